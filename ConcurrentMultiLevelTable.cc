@@ -0,0 +1,270 @@
+#include "ConcurrentMultiLevelTable.h"
+
+#include <algorithm>
+#include "ns3/tcp-header.h"
+#include "TcpPktMeta.h"
+
+
+/// ns3::Hasher keeps internal state, so every worker needs its own instances
+static void GetHashs(const FlowTuple &tuple, int mod, uint32_t *hashs) {
+    thread_local Hasher murmur3{Create<Hash::Function::Murmur3>()};
+    thread_local Hasher fnv1a{Create<Hash::Function::Fnv1a>()};
+    auto buf = reinterpret_cast<const char*>(&tuple);
+    hashs[0] = (uint32_t) murmur3.clear().GetHash32(buf, FlowTuple::SerializedSize);
+    hashs[1] = (uint32_t) murmur3.clear().GetHash64(buf, FlowTuple::SerializedSize);
+    hashs[2] = (uint32_t) fnv1a.clear().GetHash32(buf, FlowTuple::SerializedSize);
+    hashs[3] = (uint32_t) fnv1a.clear().GetHash64(buf, FlowTuple::SerializedSize);
+    for (int i = 0; i < 4; i++) {
+        hashs[i] %= mod;
+    }
+}
+
+static uint32_t XorShift(uint64_t &state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (uint32_t)(state >> 32);
+}
+
+ConcurrentMultiLevelTable::ConcurrentMultiLevelTable(const Config &cfg, int workerCnt)
+    : m_cfg{cfg},
+    m_workerCnt{workerCnt},
+    m_table(cfg.rowCnt, cfg.colCnt),
+    m_workerStats(new WorkerStats[workerCnt])
+{
+    for (int i = 0; i < workerCnt; i++) {
+        m_workerStats[i].rngState = 0x9E3779B97F4A7C15ULL * (i + 1);
+    }
+}
+
+ConcurrentMultiLevelTable::Cell& ConcurrentMultiLevelTable::CellAt(int row, int col) {
+    return m_table.At(row, col);
+}
+
+bool ConcurrentMultiLevelTable::TryLock(Cell &cell, WorkerStats &stats) {
+    uint32_t v = cell.version.load(std::memory_order_relaxed);
+    if ((v & 1) == 0
+        && cell.version.compare_exchange_strong(v, v + 1, std::memory_order_acquire)) {
+        return true;
+    }
+    stats.casFailCnt++;
+    return false;
+}
+
+void ConcurrentMultiLevelTable::Unlock(Cell &cell) {
+    cell.version.fetch_add(1, std::memory_order_release);
+}
+
+ConcurrentMultiLevelTable::CellData
+ConcurrentMultiLevelTable::ReadConsistent(const Cell &cell, WorkerStats &stats) const {
+    while (1) {
+        uint32_t v1 = cell.version.load(std::memory_order_acquire);
+        if ((v1 & 1) == 0) {
+            CellData data = cell.Load();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t v2 = cell.version.load(std::memory_order_relaxed);
+            if (v1 == v2) {
+                return data;
+            }
+        }
+        stats.readRetryCnt++;
+    }
+}
+
+int ConcurrentMultiLevelTable::PickVictim(const uint32_t *rows, nanoseconds now, WorkerStats &stats,
+                                          CellData &victimData) {
+    if (m_cfg.alpha < 0) {
+        // using random replace policy
+        int victim = XorShift(stats.rngState) % m_cfg.colCnt;
+        victimData = ReadConsistent(CellAt(rows[victim], victim), stats);
+        return victim;
+    }
+    int victim = 0;
+    uint32_t maxUpdateInterval = 0;
+    for (int col = 0; col < m_cfg.colCnt; col++) {
+        CellData data = ReadConsistent(CellAt(rows[col], col), stats);
+        // a worker lagging in trace time may see cells stamped after `now`: treat those as just updated
+        int32_t elapsed = (int32_t)((uint32_t)now.count() - data.endTime);
+        uint32_t t = std::max(elapsed, 0);
+        uint32_t updateInterval = m_cfg.alpha * t + (1 - m_cfg.alpha) * data.updateInterval;
+        if (col == 0 || updateInterval > maxUpdateInterval) {
+            victimData = data;
+        }
+        if (updateInterval > maxUpdateInterval) {
+            maxUpdateInterval = updateInterval;
+            victim = col;
+        }
+    }
+    return victim;
+}
+
+void ConcurrentMultiLevelTable::DoRecord(const TcpPktMetadata &pktMeta, int workerId) {
+    WorkerStats &stats = m_workerStats[workerId];
+    nanoseconds now = pktMeta.timestamp;
+    if (now >= m_statsBeginTs) {
+        stats.statsEnabled = true;
+    }
+
+    const FlowTuple &flow = pktMeta.flow;
+    constexpr uint8_t FlushMask = TcpHeader::FIN | TcpHeader::RST;
+    bool shouldFlush = ((pktMeta.tcpFlags & FlushMask) != 0);
+    uint32_t rows[4];
+    GetHashs(flow, m_cfg.rowCnt, rows);
+    if (!m_cfg.diffHashFunc) {
+        rows[1] = rows[2] = rows[3] = rows[0];
+    }
+
+    auto fill = [&](CellData &data) {
+        data.flow = flow;
+        data.startTime = now.count();
+        data.endTime = now.count();
+        data.pktCnt += 1;
+        data.byteCnt += pktMeta.payloadSize;
+    };
+
+    // every early `continue` below means the table changed under us: redo the packet
+    while (1) {
+        int matchCol = -1;
+        int emptyCol = -1;
+        for (int col = 0; col < m_cfg.colCnt; col++) {
+            CellData data = ReadConsistent(CellAt(rows[col], col), stats);
+            if (!data.IsValid()) {
+                if (emptyCol < 0) emptyCol = col;
+            } else if (flow == data.flow) {
+                matchCol = col;
+                break;
+            }
+        }
+
+        if (matchCol >= 0) {
+            Cell &cell = CellAt(rows[matchCol], matchCol);
+            if (!TryLock(cell, stats)) {
+                continue;
+            }
+            CellData data = cell.Load();
+            if (!data.IsValid() || flow != data.flow) {
+                // cast out by another worker between scan and claim
+                Unlock(cell);
+                stats.retryCnt++;
+                continue;
+            }
+            if (shouldFlush) {
+                data.Reset();
+                cell.Store(data);
+                Unlock(cell);
+                if (stats.statsEnabled) stats.outputRecordCnt++;
+                return;
+            }
+            nanoseconds age{(uint32_t)now.count() - data.startTime}; // wrap-safe, as in MultiLevelTable
+            bool isExpired = (m_cfg.ttl > 0us && age > m_cfg.ttl);
+            if (isExpired) {
+                data.Reset();
+                data.flow = flow;
+                data.startTime = now.count();
+            } else if (m_cfg.alpha >= 0) {
+                uint32_t sample = now.count() - data.endTime;
+                data.updateInterval = m_cfg.alpha * sample
+                                    + (1 - m_cfg.alpha) * data.updateInterval;
+            }
+            data.endTime = now.count();
+            data.pktCnt += 1;
+            data.byteCnt += pktMeta.payloadSize;
+            cell.Store(data);
+            Unlock(cell);
+            if (isExpired && stats.statsEnabled) {
+                stats.expirCnt++;
+                stats.outputRecordCnt++;
+            }
+            return;
+        }
+
+        if (shouldFlush) {
+            if (stats.statsEnabled) stats.outputRecordCnt++;
+            return;
+        }
+
+        if (emptyCol >= 0) {
+            Cell &cell = CellAt(rows[emptyCol], emptyCol);
+            if (!TryLock(cell, stats)) {
+                continue;
+            }
+            CellData data = cell.Load();
+            if (data.IsValid()) {
+                // another worker inserted here first
+                Unlock(cell);
+                stats.retryCnt++;
+                continue;
+            }
+            fill(data);
+            cell.Store(data);
+            Unlock(cell);
+            return;
+        }
+
+        CellData victimData;
+        int victim = PickVictim(rows, now, stats, victimData);
+        Cell &cell = CellAt(rows[victim], victim);
+        if (!TryLock(cell, stats)) {
+            continue;
+        }
+        CellData data = cell.Load();
+        if (data.IsValid() != victimData.IsValid()
+            || (data.IsValid() && (data.flow != victimData.flow || data.pktCnt != victimData.pktCnt
+                                   || data.endTime != victimData.endTime))) {
+            // another worker emptied, refreshed or refilled the victim (maybe with this flow) since the scan
+            Unlock(cell);
+            stats.retryCnt++;
+            continue;
+        }
+        bool castout = data.IsValid();
+        data.Reset();
+        fill(data);
+        cell.Store(data);
+        Unlock(cell);
+        if (castout && stats.statsEnabled) {
+            stats.castoutCnt++;
+            stats.outputRecordCnt++;
+        }
+        return;
+    }
+}
+
+void ConcurrentMultiLevelTable::PrintStats() const {
+    WorkerStats total;
+    for (int i = 0; i < m_workerCnt; i++) {
+        const WorkerStats &s = m_workerStats[i];
+        total.outputRecordCnt += s.outputRecordCnt;
+        total.expirCnt += s.expirCnt;
+        total.castoutCnt += s.castoutCnt;
+        total.casFailCnt += s.casFailCnt;
+        total.retryCnt += s.retryCnt;
+        total.readRetryCnt += s.readRetryCnt;
+    }
+
+    std::cout << "======== concurrent workers=" << m_workerCnt
+            << ", replacePolicy=";
+    if (m_cfg.alpha < 0) {
+        std::cout << "random";
+    } else {
+        std::cout << "alpha=" << m_cfg.alpha;
+    }
+    std::cout << ", diffHash=" << (m_cfg.diffHashFunc ? "true" : "false")
+            << ", rowCnt=" << m_cfg.rowCnt
+            << ", colCnt=" << m_cfg.colCnt
+            << ", ttl=" << m_cfg.ttl
+            << " ========"
+            << std::endl;
+    const TableArena &arena = m_table.Arena();
+    std::cout << "memory: " << arena.ResidentBytes() / 1024 << "KB resident"
+            << " of " << arena.Size() / 1024 << "KB, pages=" << ToString(arena.GetPageMode())
+            << std::endl;
+    std::cout << "records=" << total.outputRecordCnt
+            << ", expirs=" << total.expirCnt
+            << ", castOut=" << total.castoutCnt
+            << std::endl;
+    std::cout << "casFails=" << total.casFailCnt
+            << ", retries=" << total.retryCnt
+            << ", readRetries=" << total.readRetryCnt
+            << std::endl;
+    std::cout << std::endl << std::endl;
+}
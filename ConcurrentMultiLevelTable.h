@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include "MultiLevelTable.h"
+
+struct TcpPktMetadata;
+
+/// @brief MultiLevelTable shared by several ingress pipelines (worker threads).
+/// Each cell is guarded by a seqlock-style version counter: readers scan
+/// without taking anything, a writer claims a cell by CAS-ing its version
+/// from even to odd and publishes by bumping it again. A failed claim or a
+/// cell that changed under us is retried and counted as contention.
+/// @note Packets of one flow must always be fed by the same worker (e.g. RSS
+/// partitioning by flow hash), so that one flow never races with itself.
+/// @note Only the `alpha` replace policies (Ewma, or Random when negative)
+/// are supported; Config::policy and Config::resize are ignored.
+class ConcurrentMultiLevelTable {
+public:
+    using Config = MultiLevelTable::Config;
+
+    ConcurrentMultiLevelTable(const Config &config, int workerCnt);
+
+    /// thread safe as long as each worker uses its own `workerId`
+    void DoRecord(const TcpPktMetadata &pktMeta, int workerId);
+
+    void SetStatsBeginTs(nanoseconds ts) {
+        m_statsBeginTs = ts;
+    }
+    void PrintStats() const;
+
+private:
+    struct Cell;
+    struct CellData;
+    struct WorkerStats;
+
+    const Config m_cfg;
+    const int m_workerCnt;
+    ArenaArray<Cell> m_table;
+    std::unique_ptr<WorkerStats[]> m_workerStats;
+
+    nanoseconds m_statsBeginTs{0};
+
+    Cell& CellAt(int row, int col);
+    bool TryLock(Cell &cell, WorkerStats &stats);
+    void Unlock(Cell &cell);
+    CellData ReadConsistent(const Cell &cell, WorkerStats &stats) const;
+    /// @param victimData set to what the victim cell held when it was picked
+    int PickVictim(const uint32_t *rows, nanoseconds now, WorkerStats &stats, CellData &victimData);
+};
+
+
+struct ConcurrentMultiLevelTable::CellData {
+    FlowTuple flow;
+    uint32_t startTime = 0;
+    uint32_t endTime = 0;
+    uint32_t pktCnt = 0;
+    uint32_t byteCnt = 0;
+
+    uint32_t updateInterval = 0;
+
+    CellData() { flow.proto = 0; }
+
+    bool IsValid() const {
+        return flow.proto != 0;
+    }
+
+    void Reset() {
+        flow.proto = 0;
+        pktCnt = 0;
+        byteCnt = 0;
+        updateInterval = 0;
+    }
+};
+
+/// The payload is kept as atomic words and copied with relaxed loads and
+/// stores, so that a reader racing the writer is well defined (the version
+/// check then discards what it read) rather than a C++ data race.
+struct ConcurrentMultiLevelTable::Cell {
+    static constexpr size_t WordCnt = sizeof(CellData) / sizeof(uint32_t);
+    static_assert(sizeof(CellData) % sizeof(uint32_t) == 0);
+
+    /// odd while a writer owns the cell
+    std::atomic<uint32_t> version{0};
+    std::atomic<uint32_t> words[WordCnt] = {}; // all zero is an empty CellData
+
+    CellData Load() const {
+        uint32_t buf[WordCnt];
+        for (size_t i = 0; i < WordCnt; i++) {
+            buf[i] = words[i].load(std::memory_order_relaxed);
+        }
+        CellData data;
+        std::memcpy(&data, buf, sizeof(data));
+        return data;
+    }
+
+    /// only while owning the cell
+    void Store(const CellData &data) {
+        uint32_t buf[WordCnt];
+        std::memcpy(buf, &data, sizeof(data));
+        for (size_t i = 0; i < WordCnt; i++) {
+            words[i].store(buf[i], std::memory_order_relaxed);
+        }
+    }
+};
+
+/// per-worker counters, one cache line each to avoid false sharing
+struct alignas(64) ConcurrentMultiLevelTable::WorkerStats {
+    int64_t outputRecordCnt = 0;
+    int64_t expirCnt = 0;
+    int64_t castoutCnt = 0;
+
+    int64_t casFailCnt = 0;   // CAS on a cell version lost to another worker
+    int64_t retryCnt = 0;     // cell changed between scan and claim, packet redone
+    int64_t readRetryCnt = 0; // optimistic read observed a concurrent write
+
+    bool statsEnabled = false;
+    uint64_t rngState = 0;    // xorshift state for random replace policy
+};
@@ -0,0 +1,65 @@
+#include "EpochSeries.h"
+
+#include <algorithm>
+
+EpochSeries::EpochSeries(nanoseconds epochDuration, int slotCnt)
+    : m_epochDuration{epochDuration},
+    m_slotCnt{slotCnt},
+    m_slots{new Slot[slotCnt]}
+{}
+
+__attribute__((noinline))
+void EpochSeries::Roll(nanoseconds now, uint32_t occupancy) {
+    if (m_rollCnt > 0) {
+        Current().occupancy = occupancy;
+        m_current = (m_current + 1) % m_slotCnt;
+    }
+    m_rollCnt++;
+
+    // skip empty epochs, the next slot starts at the epoch containing `now`
+    nanoseconds beginTs = now / m_epochDuration * m_epochDuration;
+    Current() = Slot{};
+    Current().beginTs = beginTs.count();
+    m_epochEndTs = beginTs + m_epochDuration;
+}
+
+void EpochSeries::Save(TableSnapshot &snapshot) const {
+    snapshot.Put(m_epochDuration);
+    snapshot.Put(m_slotCnt);
+    snapshot.Put(m_current);
+    snapshot.Put(m_rollCnt);
+    snapshot.Put(m_epochEndTs);
+    snapshot.PutBytes(m_slots.get(), m_slotCnt * sizeof(Slot));
+}
+
+bool EpochSeries::Restore(TableSnapshot::Reader &reader) {
+    int slotCnt = 0;
+    if (!reader.Get(m_epochDuration) || !reader.Get(slotCnt) || slotCnt != m_slotCnt) {
+        return false;
+    }
+    return reader.Get(m_current)
+        && reader.Get(m_rollCnt)
+        && reader.Get(m_epochEndTs)
+        && reader.GetBytes(m_slots.get(), m_slotCnt * sizeof(Slot));
+}
+
+void EpochSeries::PrintCsvHeader(std::ostream &out) {
+    out << "table,epochBeginUs,pkts,records,expirs,evicts,occupancy\n";
+}
+
+void EpochSeries::PrintCsv(std::ostream &out, const std::string &label, uint32_t occupancy) const {
+    int64_t slotUsed = std::min<int64_t>(m_rollCnt, m_slotCnt);
+    int oldest = (m_current - slotUsed + 1 + m_slotCnt) % m_slotCnt;
+    for (int64_t i = 0; i < slotUsed; i++) {
+        int idx = (oldest + i) % m_slotCnt;
+        const Slot &slot = m_slots[idx];
+        out << label
+            << ',' << slot.beginTs / 1000
+            << ',' << slot.pkts
+            << ',' << slot.records
+            << ',' << slot.expirs
+            << ',' << slot.evicts
+            << ',' << (idx == m_current ? occupancy : slot.occupancy)
+            << '\n';
+    }
+}
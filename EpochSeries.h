@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include "TableSnapshot.h"
+#include "TimeHelper.h"
+
+/// @brief Per-epoch counters of a table kept in a preallocated ring.
+/// The hot path only bumps fields of the current slot; rolling to the next
+/// epoch is one timestamp compare per packet plus a slot reset per epoch.
+/// Once the ring is full, the oldest epochs are overwritten.
+class EpochSeries {
+public:
+    struct Slot {
+        int64_t beginTs = 0; // ns
+        uint32_t pkts = 0;
+        uint32_t records = 0;
+        uint32_t expirs = 0;
+        uint32_t evicts = 0;    // collisions (FlowTable) or cast-outs (MultiLevelTable)
+        uint32_t occupancy = 0; // valid cells at the end of the epoch
+    };
+
+    static constexpr int DefaultSlotCnt = 4096;
+
+    /// epoch length used by tables that don't pass their own, like FlowStats::EpochDuration
+    static nanoseconds& DefaultEpochDuration() {
+        static nanoseconds duration = 10ms;
+        return duration;
+    }
+
+    explicit EpochSeries(nanoseconds epochDuration = DefaultEpochDuration(), int slotCnt = DefaultSlotCnt);
+
+    Slot& Current() { return m_slots[m_current]; }
+
+    /// call before counting a packet at `now`; `occupancy` closes the current epoch
+    void Advance(nanoseconds now, uint32_t occupancy) {
+        if (now >= m_epochEndTs) {
+            Roll(now, occupancy);
+        }
+    }
+
+    void Save(TableSnapshot &snapshot) const;
+    /// false if the image was taken with another slot count
+    bool Restore(TableSnapshot::Reader &reader);
+
+    static void PrintCsvHeader(std::ostream &out);
+    /// one line per epoch, oldest first, each prefixed by `label`
+    void PrintCsv(std::ostream &out, const std::string &label, uint32_t occupancy) const;
+
+private:
+    nanoseconds m_epochDuration;
+    int m_slotCnt;
+    std::unique_ptr<Slot[]> m_slots;
+    int m_current = 0;
+    int64_t m_rollCnt = 0;
+    nanoseconds m_epochEndTs{0};
+
+    void Roll(nanoseconds now, uint32_t occupancy);
+};
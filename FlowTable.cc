@@ -1,34 +1,108 @@
 #include "FlowTable.h"
 
 #include <algorithm>
+#include <sstream>
 #include "ns3/simulator.h"
 #include "ns3/tcp-header.h"
 #include "TcpPktMeta.h"
 
 NS_LOG_COMPONENT_DEFINE ("FlowTable");
 
-FlowTable::FlowTable(int hashTableSize, microseconds ttl)
-    : m_hashTableSize{hashTableSize},
+FlowTable::FlowTable(int hashTableSize, microseconds ttl, const ResizePolicy &resize)
+    : m_initSize{hashTableSize},
+    m_hashTableSize{hashTableSize},
     m_ttl{ttl},
-    m_hashTable{new Record[hashTableSize]}
+    m_hashTable{std::make_unique<ArenaArray<Record>>(hashTableSize)},
+    m_resize{resize}
 {}
 
 void FlowTable::OutputRecord(Record &cell) {
     if (m_statsEnabled) {
         m_recordCnt++;
     }
+    m_epochs.Current().records++;
+    m_occupancy--;
     cell.Reset();
 }
 
+FlowTable::Record& FlowTable::Locate(uint32_t hash) {
+    int idx = hash % m_hashTableSize;
+    if (m_nextTable && idx < m_migrateCursor) {
+        return (*m_nextTable)[hash % m_nextSize];
+    }
+    return (*m_hashTable)[idx];
+}
+
+void FlowTable::CheckResize(nanoseconds now) {
+    ResizeState &st = m_resizeState;
+    if (m_nextTable || st.windowPkts < m_resize.checkPkts) {
+        return;
+    }
+    int nextSize = st.Decide(m_resize, m_hashTableSize, m_hashTableSize, m_occupancy, now.count());
+    if (nextSize == m_hashTableSize) {
+        return;
+    }
+    // buckets are constructed as they are migrated to, not all at once here
+    m_nextTable = std::make_unique<ArenaArray<Record>>(nextSize, 1, ArenaArray<Record>::Deferred{});
+    m_nextSize = nextSize;
+    m_migrateCursor = 0;
+}
+
+/// Moves the next few buckets into m_nextTable. Growing splits bucket i into
+/// i and i + size; shrinking merges buckets i and i + size/2, keeping the
+/// more recently updated record of the two.
+void FlowTable::MigrateStep() {
+    bool grow = m_nextSize > m_hashTableSize;
+    for (int i = 0; i < m_resize.migrateStep && m_migrateCursor < m_hashTableSize; i++) {
+        int idx = m_migrateCursor++;
+        if (grow) {
+            m_nextTable->Construct(idx);
+            m_nextTable->Construct(idx + m_hashTableSize);
+        } else if (idx < m_nextSize) {
+            m_nextTable->Construct(idx);
+        }
+
+        Record &from = (*m_hashTable)[idx];
+        if (!from.IsValid()) {
+            continue;
+        }
+        Record &to = (*m_nextTable)[from.flow.GetHashValue() % m_nextSize];
+        if (to.IsValid()) {
+            if ((int32_t)(from.endTime - to.endTime) > 0) {
+                std::swap(from, to);
+            }
+            m_resizeState.evictCnt++;
+            OutputRecord(from);
+        } else {
+            to = from;
+            from.Reset();
+        }
+    }
+    if (m_migrateCursor == m_hashTableSize) {
+        m_hashTable = std::move(m_nextTable);
+        m_hashTableSize = m_nextSize;
+        m_resizeState.ResetWindow();
+    }
+}
+
 void FlowTable::DoRecord(const TcpPktMetadata &pktMeta) {
     nanoseconds now = pktMeta.timestamp;
     if (now >= m_statsBeginTs) {
         m_statsEnabled = true;
     }
-    
+    m_epochs.Advance(now, m_occupancy);
+    m_epochs.Current().pkts++;
+    if (m_resize.enabled) {
+        m_resizeState.windowPkts++;
+        if (m_nextTable) {
+            MigrateStep();
+        } else {
+            CheckResize(now);
+        }
+    }
+
     const FlowTuple &flow = pktMeta.flow;
-    uint32_t idx = flow.GetHashValue() % m_hashTableSize;
-    auto &cell = m_hashTable[idx];
+    auto &cell = Locate(flow.GetHashValue());
 
     constexpr uint8_t shouldFlushMask = TcpHeader::FIN | TcpHeader::RST;
     bool shouldFlush = ((pktMeta.tcpFlags & shouldFlushMask) != 0);
@@ -37,20 +111,23 @@ void FlowTable::DoRecord(const TcpPktMetadata &pktMeta) {
         if (shouldFlush) {
             if (flow == cell.flow) {
                 OutputRecord(cell);
-            } else if (m_statsEnabled) {
-                m_recordCnt++;
+            } else {
+                if (m_statsEnabled) m_recordCnt++;
+                m_epochs.Current().records++;
             }
             return;
         }
 
-        decltype(now) startTime{cell.startTime};
-        bool isExpired = (m_ttl > 0us && now - startTime > m_ttl);
-        if (m_statsEnabled) {
-            if (flow != cell.flow) {
-                m_collisionCnt++;
-            } else if (isExpired) {
-                m_expirCnt++;
-            }
+        // cells keep the low 32 bits of ns timestamps, so ages are taken wrap-safe
+        nanoseconds age{(uint32_t)now.count() - cell.startTime};
+        bool isExpired = (m_ttl > 0us && age > m_ttl);
+        if (flow != cell.flow) {
+            if (m_statsEnabled) m_collisionCnt++;
+            m_epochs.Current().evicts++;
+            m_resizeState.windowEvicts++;
+        } else if (isExpired) {
+            if (m_statsEnabled) m_expirCnt++;
+            m_epochs.Current().expirs++;
         }
         
         if (flow != cell.flow || isExpired) {
@@ -60,10 +137,12 @@ void FlowTable::DoRecord(const TcpPktMetadata &pktMeta) {
         if (m_statsEnabled) {
             m_recordCnt++;
         }
+        m_epochs.Current().records++;
         return;
     }
 
     if (!cell.IsValid()) {
+        m_occupancy++;
         cell.flow = flow;
         cell.startTime = now.count();
     }
@@ -73,16 +152,101 @@ void FlowTable::DoRecord(const TcpPktMetadata &pktMeta) {
     cell.byteCnt += pktMeta.payloadSize;
 }
 
-void FlowTable::PrintStats() const {
-    std::cout << "========"
-            << " Table entCnt=" << m_hashTableSize
-            << ", ttl=" << m_ttl
-            << " ========\n";
-    std::cout << "records: " << m_recordCnt
+void FlowTable::PrintStats(std::ostream &out) const {
+    out << "========"
+            << " Table entCnt=" << m_initSize
+            << ", ttl=" << m_ttl;
+    if (m_resize.enabled) {
+        out << ", elastic=" << m_resize.Key();
+    }
+    out << " ========\n";
+    const TableArena &arena = m_hashTable->Arena();
+    out << "memory: " << arena.ResidentBytes() / 1024 << "KB resident"
+                << " of " << arena.Size() / 1024 << "KB, pages=" << ToString(arena.GetPageMode())
+                << std::endl;
+    out << "records: " << m_recordCnt
                 << ", expires: " << m_expirCnt
                 << ", collisions: " << m_collisionCnt
                 << std::endl;
-    std::cout << std::endl << std::endl;
+    if (m_resize.enabled) {
+        m_resizeState.PrintStats(out, m_hashTableSize);
+    }
+    out << std::endl << std::endl;
+}
+
+std::string FlowTable::ConfigKey(int hashTableSize, microseconds ttl, const ResizePolicy &resize) {
+    std::ostringstream oss;
+    oss << "FlowTable hashTableSize=" << hashTableSize << " ttlUs=" << ttl.count();
+    if (resize.enabled) {
+        oss << " resize=" << resize.Key();
+    }
+    return oss.str();
+}
+
+size_t FlowTable::MemoryBytes(int hashTableSize, const ResizePolicy &resize) {
+    if (resize.enabled) {
+        // the largest table plus the half-size one it may be growing from
+        size_t rows = (size_t)resize.maxRows + resize.maxRows / 2;
+        return ArenaArray<Record>::BytesFor(rows);
+    }
+    return ArenaArray<Record>::BytesFor(hashTableSize);
+}
+
+TableCounters FlowTable::GetCounters() const {
+    TableCounters counters;
+    counters.records = m_recordCnt;
+    counters.expirs = m_expirCnt;
+    counters.evicts = m_collisionCnt;
+    counters.occupancy = m_occupancy;
+    counters.memBytes = ArenaArray<Record>::BytesFor(m_hashTableSize);
+    return counters;
+}
+
+static constexpr uint32_t FlowTableSnapshotMagic = 0x46544231; // "FTB1"
+
+bool FlowTable::Snapshot(TableSnapshot &snapshot) const {
+    if (m_resize.enabled) {
+        return false;
+    }
+    snapshot.Put(FlowTableSnapshotMagic);
+    snapshot.Put(m_hashTableSize);
+    snapshot.PutBytes(m_hashTable->Bytes(), m_hashTable->ByteSize());
+    snapshot.Put(m_statsBeginTs);
+    snapshot.Put(m_statsEnabled);
+    snapshot.Put(m_recordCnt);
+    snapshot.Put(m_expirCnt);
+    snapshot.Put(m_collisionCnt);
+    snapshot.Put(m_occupancy);
+    m_epochs.Save(snapshot);
+    return true;
+}
+
+bool FlowTable::Restore(const TableSnapshot &snapshot) {
+    TableSnapshot::Reader reader{snapshot};
+    uint32_t magic = 0;
+    int hashTableSize = 0;
+    if (m_resize.enabled
+        || !reader.Get(magic) || magic != FlowTableSnapshotMagic
+        || !reader.Get(hashTableSize) || hashTableSize != m_hashTableSize) {
+        return false;
+    }
+    return reader.GetBytes(m_hashTable->Bytes(), m_hashTable->ByteSize())
+        && reader.Get(m_statsBeginTs)
+        && reader.Get(m_statsEnabled)
+        && reader.Get(m_recordCnt)
+        && reader.Get(m_expirCnt)
+        && reader.Get(m_collisionCnt)
+        && reader.Get(m_occupancy)
+        && m_epochs.Restore(reader);
+}
+
+void FlowTable::PrintEpochCsv(std::ostream &out) const {
+    std::ostringstream label;
+    label << "FlowTable entCnt=" << m_initSize << " ttl=" << m_ttl;
+    if (m_resize.enabled) {
+        label << " elastic=" << ToString(m_resize.trigger);
+    }
+    m_epochs.PrintCsv(out, label.str(), m_occupancy);
 }
 
 
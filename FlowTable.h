@@ -3,7 +3,12 @@
 #include <memory>
 #include <set>
 #include <vector>
+#include "EpochSeries.h"
 #include "FlowTuple.h"
+#include "ResizePolicy.h"
+#include "TableCounters.h"
+#include "TableSnapshot.h"
+#include "TableArena.h"
 #include "TimeHelper.h"
 
 using namespace ns3;
@@ -12,7 +17,8 @@ struct TcpPktMetadata;
 
 class FlowTable {
 public:
-    FlowTable(int hashTableSize = 4096, microseconds ttl = -1us);
+    /// @param resize if enabled, the table doubles or halves online, starting at `hashTableSize`
+    FlowTable(int hashTableSize = 4096, microseconds ttl = -1us, const ResizePolicy &resize = {});
     ~FlowTable() = default;
 
     void DoRecord(const TcpPktMetadata &pktMeta);
@@ -21,14 +27,35 @@ public:
         m_statsEnabled = false;
         m_statsBeginTs = ts;
     }
-    void PrintStats() const;
+    void PrintStats(std::ostream &out = std::cout) const;
+    void PrintEpochCsv(std::ostream &out) const;
+    TableCounters GetCounters() const;
+
+    /// Full table state (cells, counters, stats flags, epochs) so that tables
+    /// with other TTLs can resume from it. Elastic tables are not supported.
+    bool Snapshot(TableSnapshot &snapshot) const;
+    /// false unless the snapshot was taken from a table of this size
+    bool Restore(const TableSnapshot &snapshot);
+
+    /// canonical config serialization, e.g. for ResultCache
+    static std::string ConfigKey(int hashTableSize, microseconds ttl, const ResizePolicy &resize = {});
+    /// table memory (cells), e.g. for budgeting batch jobs
+    static size_t MemoryBytes(int hashTableSize, const ResizePolicy &resize = {});
 
 private:
     struct Record;
 
+    const int m_initSize;
     int m_hashTableSize;
     microseconds m_ttl;
-    std::unique_ptr<Record[]> m_hashTable;
+    std::unique_ptr<ArenaArray<Record>> m_hashTable;
+
+    // while resizing, buckets below m_migrateCursor already live in m_nextTable
+    const ResizePolicy m_resize;
+    ResizeState m_resizeState;
+    std::unique_ptr<ArenaArray<Record>> m_nextTable;
+    int m_nextSize = 0;
+    int m_migrateCursor = 0;
 
     nanoseconds m_statsBeginTs{0};
     bool m_statsEnabled = true;
@@ -36,7 +63,13 @@ private:
     int m_expirCnt = 0;
     int m_collisionCnt = 0;
 
+    EpochSeries m_epochs;
+    uint32_t m_occupancy = 0;
+
     void OutputRecord(Record &cell);
+    Record& Locate(uint32_t hash);
+    void CheckResize(nanoseconds now);
+    void MigrateStep();
 };
 
 
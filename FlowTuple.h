@@ -1,6 +1,7 @@
 #pragma once
 
 #include <tuple>
+#include "ns3/hash.h"
 #include "ns3/tcp-l4-protocol.h"
 #include "ns3/udp-l4-protocol.h"
 using namespace ns3;
@@ -14,8 +15,11 @@ struct FlowTuple {
 
     static constexpr int SerializedSize = 13;
 
+    /// same value as ns3::Hash32, but through a per-thread Hasher: the global
+    /// one keeps internal state, so tables can't share it across workers
     uint32_t GetHashValue() const {
-        return Hash32(reinterpret_cast<const char*>(this), SerializedSize);
+        thread_local Hasher murmur3{Create<Hash::Function::Murmur3>()};
+        return murmur3.clear().GetHash32(reinterpret_cast<const char*>(this), SerializedSize);
     }
 
     bool operator == (const FlowTuple &another) const {
@@ -0,0 +1,113 @@
+#include "JobScheduler.h"
+
+#include <algorithm>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+JobScheduler::JobScheduler(int workerCnt, size_t memBudget)
+    : m_workerCnt{std::max(workerCnt, 1)}, m_memBudget{memBudget}
+{}
+
+int JobScheduler::AddTask(Task task) {
+    m_tasks.push_back(std::move(task));
+    m_states.push_back(State::Pending);
+    m_pids.push_back(-1);
+    return m_tasks.size() - 1;
+}
+
+bool JobScheduler::IsReady(int id) const {
+    for (int dep : m_tasks[id].deps) {
+        if (m_states[dep] != State::Succeeded) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JobScheduler::Start(int id) {
+    const Task &task = m_tasks[id];
+    std::cout.flush(); // or the child inherits and repeats buffered output
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        int fd = open(task.logFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        std::vector<char*> argv;
+        for (const auto &arg : task.argv) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    m_pids[id] = pid;
+    m_states[id] = State::Running;
+    std::cout << "[batch] start " << task.name << std::endl;
+    return true;
+}
+
+bool JobScheduler::Run() {
+    int taskCnt = m_tasks.size();
+    int runningCnt = 0;
+    size_t usedMem = 0;
+    while (1) {
+        // skip tasks whose dependencies failed
+        for (int id = 0; id < taskCnt; id++) {
+            if (m_states[id] != State::Pending) continue;
+            for (int dep : m_tasks[id].deps) {
+                if (m_states[dep] == State::Failed || m_states[dep] == State::Skipped) {
+                    m_states[id] = State::Skipped;
+                    std::cout << "[batch] skip " << m_tasks[id].name << std::endl;
+                    break;
+                }
+            }
+        }
+
+        for (int id = 0; id < taskCnt && runningCnt < m_workerCnt; id++) {
+            if (m_states[id] != State::Pending || !IsReady(id)) continue;
+            size_t mem = m_tasks[id].memBytes;
+            if (runningCnt > 0 && usedMem + mem > m_memBudget) continue;
+            if (!Start(id)) {
+                m_states[id] = State::Failed;
+                continue;
+            }
+            runningCnt++;
+            usedMem += mem;
+        }
+
+        if (runningCnt == 0) {
+            break; // nothing running and nothing startable: done
+        }
+
+        int status = 0;
+        pid_t pid = wait(&status);
+        if (pid < 0) {
+            break;
+        }
+        for (int id = 0; id < taskCnt; id++) {
+            if (m_pids[id] != pid || m_states[id] != State::Running) continue;
+            bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            m_states[id] = ok ? State::Succeeded : State::Failed;
+            runningCnt--;
+            usedMem -= m_tasks[id].memBytes;
+            std::cout << "[batch] " << (ok ? "done " : "FAILED ") << m_tasks[id].name << std::endl;
+            break;
+        }
+    }
+
+    bool allOk = true;
+    for (int id = 0; id < taskCnt; id++) {
+        if (m_states[id] != State::Succeeded) {
+            allOk = false;
+        }
+    }
+    return allOk;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/// @brief Runs a dependency graph of child processes on a local worker pool.
+/// A task starts once all its dependencies succeeded, a worker is free and
+/// its memory estimate fits into the budget (a task is always started when
+/// nothing else runs, so an oversized task can't stall the graph). Ready
+/// tasks start in the order they were added.
+class JobScheduler {
+public:
+    struct Task {
+        std::string name;
+        std::vector<std::string> argv; // argv[0] is the executable
+        std::string logFilename;       // stdout and stderr of the task
+        size_t memBytes = 0;           // estimated peak memory
+        std::vector<int> deps;         // ids returned by AddTask
+    };
+
+    JobScheduler(int workerCnt, size_t memBudget);
+
+    int AddTask(Task task);
+
+    /// @return true if every task succeeded
+    bool Run();
+
+    bool Succeeded(int id) const { return m_states[id] == State::Succeeded; }
+    const Task& GetTask(int id) const { return m_tasks[id]; }
+
+private:
+    enum class State { Pending, Running, Succeeded, Failed, Skipped };
+
+    int m_workerCnt;
+    size_t m_memBudget;
+    std::vector<Task> m_tasks;
+    std::vector<State> m_states;
+    std::vector<pid_t> m_pids;
+
+    bool IsReady(int id) const;
+    bool Start(int id);
+};
@@ -1,64 +1,272 @@
 #include "MultiLevelTable.h"
 
+#include <algorithm>
+#include <sstream>
 #include "ns3/tcp-header.h"
 #include "TcpPktMeta.h"
 
 
-static Hasher murmur3{Create<Hash::Function::Murmur3>()};
-static Hasher fnv1a{Create<Hash::Function::Fnv1a>()};
-std::vector<uint32_t> GetHashs(const FlowTuple &tuple, int mod) {
-    std::vector<uint32_t> ret {
-        (uint32_t) murmur3.clear().GetHash32(reinterpret_cast<const char*>(&tuple), 13),
-        (uint32_t) murmur3.clear().GetHash64(reinterpret_cast<const char*>(&tuple), 13),
-        (uint32_t) fnv1a.clear().GetHash32(reinterpret_cast<const char*>(&tuple), 13),
-        (uint32_t) fnv1a.clear().GetHash64(reinterpret_cast<const char*>(&tuple), 13)
-    };
-    for (auto &x : ret) {
-        x %= mod;
+/// full hash value of column `col` (one of up to 4 hash functions); rows are
+/// taken modulo the current rowCnt, which changes on resize
+static uint32_t GetHash(const FlowTuple &tuple, bool diffHashFunc, int col) {
+    // ns3::Hasher keeps internal state, so every thread replaying tables needs its own
+    thread_local Hasher murmur3{Create<Hash::Function::Murmur3>()};
+    thread_local Hasher fnv1a{Create<Hash::Function::Fnv1a>()};
+    auto buf = reinterpret_cast<const char*>(&tuple);
+    switch (diffHashFunc ? col : 0) {
+    case 0:  return (uint32_t) murmur3.clear().GetHash32(buf, FlowTuple::SerializedSize);
+    case 1:  return (uint32_t) murmur3.clear().GetHash64(buf, FlowTuple::SerializedSize);
+    case 2:  return (uint32_t) fnv1a.clear().GetHash32(buf, FlowTuple::SerializedSize);
+    default: return (uint32_t) fnv1a.clear().GetHash64(buf, FlowTuple::SerializedSize);
     }
-    return ret;
+}
+
+static MultiLevelTable::ReplacePolicy EffectivePolicy(const MultiLevelTable::Config &cfg) {
+    using ReplacePolicy = MultiLevelTable::ReplacePolicy;
+    return (cfg.policy == ReplacePolicy::Ewma && cfg.alpha < 0) ? ReplacePolicy::Random : cfg.policy;
 }
 
 MultiLevelTable::MultiLevelTable(const Config &cfg)
-    : m_cfg{cfg}, m_table(new Cell[cfg.rowCnt * cfg.colCnt])
+    : m_cfg{cfg},
+    m_policy{EffectivePolicy(cfg)},
+    m_rowCnt{cfg.rowCnt},
+    m_table{std::make_unique<ArenaArray<Cell>>(cfg.rowCnt, cfg.colCnt)}
 {
-    m_random = CreateObject<UniformRandomVariable> ();
-    m_random->SetStream(1);
+    if (m_policy == ReplacePolicy::ProbDecay) {
+        // the only floating point of ProbDecay, done once here; capped since
+        // p never drops below 2^-32 when decayBase <= 1
+        constexpr size_t MaxDecayThresholds = 1 << 16;
+        double p = 1;
+        while (p * 4294967296.0 >= 1 && m_decayThresholds.size() < MaxDecayThresholds) {
+            m_decayThresholds.push_back((uint32_t)std::min(p * 4294967296.0, 4294967295.0));
+            p /= cfg.decayBase;
+        }
+    }
 }
 
 MultiLevelTable::Cell& MultiLevelTable::CellAt(int row, int col) {
-    return m_table[row * m_cfg.colCnt + col];
+    return m_table->At(row, col);
+}
+
+MultiLevelTable::Cell& MultiLevelTable::Locate(uint32_t hash, int col) {
+    int row = hash % m_rowCnt;
+    if (m_nextTable && row < m_migrateCursor) {
+        return m_nextTable->At(hash % m_nextRowCnt, col);
+    }
+    return CellAt(row, col);
+}
+
+void MultiLevelTable::CheckResize(nanoseconds now) {
+    ResizeState &st = m_resizeState;
+    if (m_nextTable || st.windowPkts < m_cfg.resize.checkPkts) {
+        return;
+    }
+    int nextRowCnt = st.Decide(m_cfg.resize, m_rowCnt, (size_t)m_rowCnt * m_cfg.colCnt, m_occupancy, now.count());
+    if (nextRowCnt == m_rowCnt) {
+        return;
+    }
+    // rows are constructed as they are migrated to, not all at once here
+    m_nextTable = std::make_unique<ArenaArray<Cell>>(nextRowCnt, m_cfg.colCnt,
+                                                     ArenaArray<Cell>::Deferred{});
+    m_nextRowCnt = nextRowCnt;
+    m_migrateCursor = 0;
+}
+
+/// Moves the next few rows into m_nextTable, every cell staying in its
+/// column. Growing splits row r into r and r + rowCnt; shrinking merges rows
+/// r and r + rowCnt/2, keeping the more recently updated cell of the two.
+void MultiLevelTable::MigrateStep() {
+    const int colCnt = m_cfg.colCnt;
+    bool grow = m_nextRowCnt > m_rowCnt;
+    for (int i = 0; i < m_cfg.resize.migrateStep && m_migrateCursor < m_rowCnt; i++) {
+        int row = m_migrateCursor++;
+        if (grow) {
+            m_nextTable->Construct(row);
+            m_nextTable->Construct(row + m_rowCnt);
+        } else if (row < m_nextRowCnt) {
+            m_nextTable->Construct(row);
+        }
+
+        for (int col = 0; col < colCnt; col++) {
+            Cell &from = CellAt(row, col);
+            if (!from.IsValid()) {
+                continue;
+            }
+            uint32_t hash = GetHash(from.flow, m_cfg.diffHashFunc, col);
+            Cell &to = m_nextTable->At(hash % m_nextRowCnt, col);
+            if (to.IsValid()) {
+                if ((int32_t)(from.endTime - to.endTime) > 0) {
+                    std::swap(from, to);
+                }
+                m_resizeState.evictCnt++;
+                OutputRecord(from);
+            } else {
+                to = from;
+                from.Reset();
+            }
+        }
+    }
+    if (m_migrateCursor == m_rowCnt) {
+        m_table = std::move(m_nextTable);
+        m_rowCnt = m_nextRowCnt;
+        m_resizeState.ResetWindow();
+    }
 }
 
 void MultiLevelTable::OutputRecord(Cell &cell) {
     cell.Reset();
+    m_occupancy--;
     if (m_statsEnabled) {
         m_outputRecordCnt++;
     }
+    m_epochs.Current().records++;
 }
 
-void MultiLevelTable::DoRecord(const TcpPktMetadata &pktMeta) {
+uint64_t MultiLevelTable::NextRandom() {
+    uint64_t &x = m_rngState;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+}
+
+
+/// Hooks of a replace policy, all static so that DoRecordWith<Policy> inlines them.
+/// PickVictim returns the column to cast out, or -1 to not admit the new flow.
+struct MultiLevelTable::PolicyBase {
+    static void OnInsert(MultiLevelTable&, Cell&) {}
+    static void OnHit(MultiLevelTable&, Cell&, uint32_t /*now*/) {}
+};
+
+struct MultiLevelTable::EwmaPolicy : PolicyBase {
+    static void OnHit(MultiLevelTable &tbl, Cell &cell, uint32_t now) {
+        uint32_t sample = now - cell.endTime;
+        cell.policyState = tbl.m_cfg.alpha * sample
+                         + (1 - tbl.m_cfg.alpha) * cell.policyState;
+    }
+    static int PickVictim(MultiLevelTable &tbl, Cell *const *cells, uint32_t now) {
+        int victim = 0;
+        uint32_t maxUpdateInterval = 0;
+        for (int col = 0; col < tbl.m_cfg.colCnt; col++) {
+            uint32_t t = now - cells[col]->endTime;
+            uint32_t updateInterval = tbl.m_cfg.alpha * t + (1 - tbl.m_cfg.alpha) * cells[col]->policyState;
+            if (updateInterval > maxUpdateInterval) {
+                maxUpdateInterval = updateInterval;
+                victim = col;
+            }
+        }
+        return victim;
+    }
+};
+
+struct MultiLevelTable::RandomPolicy : PolicyBase {
+    static int PickVictim(MultiLevelTable &tbl, Cell *const *, uint32_t) {
+        return (tbl.NextRandom() >> 32) % tbl.m_cfg.colCnt;
+    }
+};
+
+/// first column minimizing `key`, written as selects so it compiles branch-free
+template <class Key>
+static int ArgMin(int colCnt, Key key) {
+    int victim = 0;
+    uint32_t best = key(0);
+    for (int col = 1; col < colCnt; col++) {
+        uint32_t k = key(col);
+        victim = (k < best) ? col : victim;
+        best = (k < best) ? k : best;
+    }
+    return victim;
+}
+
+struct MultiLevelTable::LruPolicy : PolicyBase {
+    static int PickVictim(MultiLevelTable &tbl, Cell *const *cells, uint32_t now) {
+        // largest age, wrap-safe on the 32-bit ns timestamps
+        return ArgMin(tbl.m_cfg.colCnt, [&](int col) { return ~(now - cells[col]->endTime); });
+    }
+};
+
+struct MultiLevelTable::MinPktPolicy : PolicyBase {
+    static int PickVictim(MultiLevelTable &tbl, Cell *const *cells, uint32_t) {
+        return ArgMin(tbl.m_cfg.colCnt, [&](int col) { return cells[col]->pktCnt; });
+    }
+};
+
+struct MultiLevelTable::MinBytePolicy : PolicyBase {
+    static int PickVictim(MultiLevelTable &tbl, Cell *const *cells, uint32_t) {
+        return ArgMin(tbl.m_cfg.colCnt, [&](int col) { return cells[col]->byteCnt; });
+    }
+};
+
+struct MultiLevelTable::ShiftEwmaPolicy : PolicyBase {
+    static uint32_t Blend(uint32_t ewma, uint32_t sample, int shift) {
+        return ewma - (ewma >> shift) + (sample >> shift);
+    }
+    static void OnHit(MultiLevelTable &tbl, Cell &cell, uint32_t now) {
+        cell.policyState = Blend(cell.policyState, now - cell.endTime, tbl.m_cfg.alphaShift);
+    }
+    static int PickVictim(MultiLevelTable &tbl, Cell *const *cells, uint32_t now) {
+        int shift = tbl.m_cfg.alphaShift;
+        return ArgMin(tbl.m_cfg.colCnt, [&](int col) {
+            return ~Blend(cells[col]->policyState, now - cells[col]->endTime, shift);
+        });
+    }
+};
+
+struct MultiLevelTable::ProbDecayPolicy : PolicyBase {
+    static void OnInsert(MultiLevelTable&, Cell &cell) {
+        cell.policyState = 1;
+    }
+    static void OnHit(MultiLevelTable&, Cell &cell, uint32_t) {
+        cell.policyState++;
+    }
+    static int PickVictim(MultiLevelTable &tbl, Cell *const *cells, uint32_t) {
+        int weakest = ArgMin(tbl.m_cfg.colCnt, [&](int col) { return cells[col]->policyState; });
+        uint32_t &strength = cells[weakest]->policyState;
+        uint32_t draw = tbl.NextRandom() >> 32;
+        const auto &thresholds = tbl.m_decayThresholds;
+        if (strength < thresholds.size() && draw < thresholds[strength]) {
+            strength--;
+        }
+        if (strength == 0) {
+            return weakest;
+        }
+        if (tbl.m_statsEnabled) tbl.m_bypassCnt++;
+        return -1;
+    }
+};
+
+
+template <class Policy>
+void MultiLevelTable::DoRecordWith(const TcpPktMetadata &pktMeta) {
     nanoseconds now = pktMeta.timestamp;
     if (now >= m_statsBeginTs) {
         m_statsEnabled = true;
     }
+    m_epochs.Advance(now, m_occupancy);
+    m_epochs.Current().pkts++;
+    if (m_cfg.resize.enabled) {
+        m_resizeState.windowPkts++;
+        if (m_nextTable) {
+            MigrateStep();
+        } else {
+            CheckResize(now);
+        }
+    }
 
     const FlowTuple &flow = pktMeta.flow;
     constexpr uint8_t FlushMask = TcpHeader::FIN | TcpHeader::RST;
     bool shouldFlush = ((pktMeta.tcpFlags & FlushMask) != 0);
-    auto hashs = GetHashs(flow, m_cfg.rowCnt);
-    if (!m_cfg.diffHashFunc) {
-        for (int i = 1; i < (int)hashs.size(); i++) {
-            hashs[i] = hashs[0];
+    Cell *cells[4]; // GetHash has at most 4 hash functions
+    uint32_t hash = 0;
+    for (int col = 0; col < m_cfg.colCnt; col++) {
+        if (col == 0 || m_cfg.diffHashFunc) {
+            hash = GetHash(flow, m_cfg.diffHashFunc, col);
         }
+        cells[col] = &Locate(hash, col);
     }
 
-    auto getCell = [&hashs, this](int col) -> Cell& {
-        return CellAt(hashs[col], col);
-    };
-
     for (int col = 0; col < m_cfg.colCnt; col++) {
-        Cell &cell = getCell(col);
+        Cell &cell = *cells[col];
         if ((!cell.IsValid()) || flow != cell.flow) {
             continue;
         }
@@ -66,17 +274,19 @@ void MultiLevelTable::DoRecord(const TcpPktMetadata &pktMeta) {
             OutputRecord(cell);
             return;
         }
-        decltype(now) startTime{cell.startTime};
-        bool isExpired = (m_cfg.ttl > 0us && now - startTime > m_cfg.ttl);
+        // cells keep the low 32 bits of ns timestamps, so ages are taken wrap-safe
+        nanoseconds age{(uint32_t)now.count() - cell.startTime};
+        bool isExpired = (m_cfg.ttl > 0us && age > m_cfg.ttl);
         if (isExpired) {
             if (m_statsEnabled) m_expirCnt++;
+            m_epochs.Current().expirs++;
             OutputRecord(cell);
+            m_occupancy++;
             cell.flow = flow;
             cell.startTime = now.count();
-        } else if (m_cfg.alpha >= 0) {
-            uint32_t sample = now.count() - cell.endTime;
-            cell.updateInterval = m_cfg.alpha * sample
-                                + (1 - m_cfg.alpha) * cell.updateInterval;
+            Policy::OnInsert(*this, cell);
+        } else {
+            Policy::OnHit(*this, cell, now.count());
         }
         cell.endTime = now.count();
         cell.pktCnt += 1;
@@ -88,62 +298,197 @@ void MultiLevelTable::DoRecord(const TcpPktMetadata &pktMeta) {
         if (m_statsEnabled) {
             m_outputRecordCnt++;
         }
+        m_epochs.Current().records++;
         return;
     }
     
     int colToInsert = -1;
     for (int col = 0; col < m_cfg.colCnt; col++) {
-        if (!getCell(col).IsValid()) {
+        if (!cells[col]->IsValid()) {
             colToInsert = col;
             break;
         }
     }
     if (colToInsert < 0) {
-        if (m_cfg.alpha < 0) {
-            // using random replace policy
-            colToInsert = m_random->GetInteger(0, m_cfg.colCnt - 1);
-        } else {
-            colToInsert = 0;
-            uint32_t maxUpdateInterval = 0;
-            getCell(0).updateInterval;
-            for (int col = 0; col < m_cfg.colCnt; col++) {
-                Cell &cell = getCell(col);
-                uint32_t t = now.count() - cell.endTime;
-                uint32_t updateInterval = m_cfg.alpha * t + (1 - m_cfg.alpha) * cell.updateInterval;
-                if (updateInterval > maxUpdateInterval) {
-                    maxUpdateInterval = updateInterval;
-                    colToInsert = col;
-                }
-            }
+        colToInsert = Policy::PickVictim(*this, cells, now.count());
+        if (colToInsert < 0) {
+            return;
         }
         if (m_statsEnabled) m_castoutCnt++;
-        OutputRecord(getCell(colToInsert));
+        m_epochs.Current().evicts++;
+        m_resizeState.windowEvicts++;
+        OutputRecord(*cells[colToInsert]);
     }
 
-    Cell &cell = getCell(colToInsert);
+    Cell &cell = *cells[colToInsert];
+    m_occupancy++;
     cell.flow = flow;
     cell.startTime = now.count();
     cell.endTime = now.count();
     cell.pktCnt += 1;
     cell.byteCnt += pktMeta.payloadSize;
+    Policy::OnInsert(*this, cell);
+}
+
+void MultiLevelTable::DoRecord(const TcpPktMetadata &pktMeta) {
+    // one predictable branch per packet instead of a virtual call
+    switch (m_policy) {
+    case ReplacePolicy::Ewma:      DoRecordWith<EwmaPolicy>(pktMeta); break;
+    case ReplacePolicy::Random:    DoRecordWith<RandomPolicy>(pktMeta); break;
+    case ReplacePolicy::Lru:       DoRecordWith<LruPolicy>(pktMeta); break;
+    case ReplacePolicy::MinPkt:    DoRecordWith<MinPktPolicy>(pktMeta); break;
+    case ReplacePolicy::MinByte:   DoRecordWith<MinBytePolicy>(pktMeta); break;
+    case ReplacePolicy::ShiftEwma: DoRecordWith<ShiftEwmaPolicy>(pktMeta); break;
+    case ReplacePolicy::ProbDecay: DoRecordWith<ProbDecayPolicy>(pktMeta); break;
+    }
 }
 
-void MultiLevelTable::PrintStats() const {
-    std::cout << "======== replacePolicy=";
-    if (m_cfg.alpha < 0) {
-        std::cout << "random";
-    } else {
-        std::cout << "alpha=" << m_cfg.alpha;
+std::string MultiLevelTable::PolicyLabel() const {
+    std::ostringstream oss;
+    switch (m_policy) {
+    case ReplacePolicy::Ewma:      oss << "alpha=" << m_cfg.alpha; break;
+    case ReplacePolicy::Random:    oss << "random"; break;
+    case ReplacePolicy::Lru:       oss << "lru"; break;
+    case ReplacePolicy::MinPkt:    oss << "minPkt"; break;
+    case ReplacePolicy::MinByte:   oss << "minByte"; break;
+    case ReplacePolicy::ShiftEwma: oss << "shiftEwma=2^-" << m_cfg.alphaShift; break;
+    case ReplacePolicy::ProbDecay: oss << "probDecay=" << m_cfg.decayBase; break;
     }
-    std::cout << ", diffHash=" << (m_cfg.diffHashFunc ? "true" : "false")
+    return oss.str();
+}
+
+void MultiLevelTable::PrintStats(std::ostream &out) const {
+    out << "======== replacePolicy=" << PolicyLabel()
+            << ", diffHash=" << (m_cfg.diffHashFunc ? "true" : "false")
             << ", rowCnt=" << m_cfg.rowCnt
             << ", colCnt=" << m_cfg.colCnt
-            << ", ttl=" << m_cfg.ttl
-            << " ========"
+            << ", ttl=" << m_cfg.ttl;
+    if (m_cfg.resize.enabled) {
+        out << ", elastic=" << m_cfg.resize.Key();
+    }
+    out << " ========"
             << std::endl;
-    std::cout << "records=" << m_outputRecordCnt
-            << ", expirs=" << m_expirCnt
-            << ", castOut=" << m_castoutCnt
+    const TableArena &arena = m_table->Arena();
+    out << "memory: " << arena.ResidentBytes() / 1024 << "KB resident"
+            << " of " << arena.Size() / 1024 << "KB, pages=" << ToString(arena.GetPageMode())
             << std::endl;
-    std::cout << std::endl << std::endl;
+    out << "records=" << m_outputRecordCnt
+            << ", expirs=" << m_expirCnt
+            << ", castOut=" << m_castoutCnt;
+    if (m_policy == ReplacePolicy::ProbDecay) {
+        out << ", bypass=" << m_bypassCnt;
+    }
+    out << std::endl;
+    if (m_cfg.resize.enabled) {
+        m_resizeState.PrintStats(out, m_rowCnt);
+    }
+    out << std::endl << std::endl;
+}
+
+std::string MultiLevelTable::ConfigKey(const Config &cfg) {
+    std::ostringstream oss;
+    oss << "MultiLevelTable rowCnt=" << cfg.rowCnt
+        << " colCnt=" << cfg.colCnt
+        << " ttlUs=" << cfg.ttl.count()
+        << " alpha=" << std::hexfloat << cfg.alpha << std::defaultfloat
+        << " diffHash=" << cfg.diffHashFunc
+        << " policy=" << (int)cfg.policy
+        << " alphaShift=" << cfg.alphaShift
+        << " decayBase=" << std::hexfloat << cfg.decayBase;
+    if (cfg.resize.enabled) {
+        oss << " resize=" << cfg.resize.Key();
+    }
+    return oss.str();
+}
+
+size_t MultiLevelTable::MemoryBytes(const Config &cfg) {
+    if (cfg.resize.enabled) {
+        // the largest table plus the half-size one it may be growing from
+        size_t rowCnt = (size_t)cfg.resize.maxRows + cfg.resize.maxRows / 2;
+        return ArenaArray<Cell>::BytesFor(rowCnt, cfg.colCnt);
+    }
+    return ArenaArray<Cell>::BytesFor(cfg.rowCnt, cfg.colCnt);
+}
+
+std::string MultiLevelTable::SnapshotKey(const Config &cfg) {
+    std::ostringstream oss;
+    oss << "MultiLevelTable rowCnt=" << cfg.rowCnt
+        << " colCnt=" << cfg.colCnt
+        << " diffHash=" << cfg.diffHashFunc
+        << " policy=" << (int)EffectivePolicy(cfg);
+    return oss.str();
+}
+
+TableCounters MultiLevelTable::GetCounters() const {
+    TableCounters counters;
+    counters.records = m_outputRecordCnt;
+    counters.expirs = m_expirCnt;
+    counters.evicts = m_castoutCnt;
+    counters.occupancy = m_occupancy;
+    counters.memBytes = ArenaArray<Cell>::BytesFor(m_rowCnt, m_cfg.colCnt);
+    return counters;
+}
+
+static constexpr uint32_t MultiLevelTableSnapshotMagic = 0x4D4C5431; // "MLT1"
+
+bool MultiLevelTable::Snapshot(TableSnapshot &snapshot) const {
+    if (m_cfg.resize.enabled) {
+        return false;
+    }
+    snapshot.Put(MultiLevelTableSnapshotMagic);
+    snapshot.Put(m_rowCnt);
+    snapshot.Put(m_cfg.colCnt);
+    snapshot.Put(m_cfg.diffHashFunc);
+    snapshot.Put(m_policy);
+    snapshot.PutBytes(m_table->Bytes(), m_table->ByteSize());
+    snapshot.Put(m_rngState);
+    snapshot.Put(m_statsBeginTs);
+    snapshot.Put(m_statsEnabled);
+    snapshot.Put(m_outputRecordCnt);
+    snapshot.Put(m_expirCnt);
+    snapshot.Put(m_castoutCnt);
+    snapshot.Put(m_bypassCnt);
+    snapshot.Put(m_occupancy);
+    m_epochs.Save(snapshot);
+    return true;
+}
+
+bool MultiLevelTable::Restore(const TableSnapshot &snapshot) {
+    TableSnapshot::Reader reader{snapshot};
+    uint32_t magic = 0;
+    int rowCnt = 0;
+    int colCnt = 0;
+    bool diffHashFunc = false;
+    ReplacePolicy policy{};
+    if (m_cfg.resize.enabled
+        || !reader.Get(magic) || magic != MultiLevelTableSnapshotMagic
+        || !reader.Get(rowCnt) || rowCnt != m_rowCnt
+        || !reader.Get(colCnt) || colCnt != m_cfg.colCnt
+        || !reader.Get(diffHashFunc) || diffHashFunc != m_cfg.diffHashFunc
+        || !reader.Get(policy) || policy != m_policy) {
+        return false;
+    }
+    return reader.GetBytes(m_table->Bytes(), m_table->ByteSize())
+        && reader.Get(m_rngState)
+        && reader.Get(m_statsBeginTs)
+        && reader.Get(m_statsEnabled)
+        && reader.Get(m_outputRecordCnt)
+        && reader.Get(m_expirCnt)
+        && reader.Get(m_castoutCnt)
+        && reader.Get(m_bypassCnt)
+        && reader.Get(m_occupancy)
+        && m_epochs.Restore(reader);
+}
+
+void MultiLevelTable::PrintEpochCsv(std::ostream &out) const {
+    std::ostringstream label;
+    label << "MultiLevelTable " << PolicyLabel()
+          << " diffHash=" << (m_cfg.diffHashFunc ? "true" : "false")
+          << " rowCnt=" << m_cfg.rowCnt
+          << " colCnt=" << m_cfg.colCnt
+          << " ttl=" << m_cfg.ttl;
+    if (m_cfg.resize.enabled) {
+        label << " elastic=" << ToString(m_cfg.resize.trigger);
+    }
+    m_epochs.PrintCsv(out, label.str(), m_occupancy);
 }
\ No newline at end of file
@@ -1,18 +1,40 @@
 #pragma once
+#include <memory>
+#include <vector>
 #include "ns3/core-module.h"
+#include "EpochSeries.h"
 #include "FlowTuple.h"
+#include "ResizePolicy.h"
+#include "TableCounters.h"
+#include "TableSnapshot.h"
+#include "TableArena.h"
 #include "TimeHelper.h"
 
 struct TcpPktMetadata;
 
 class MultiLevelTable {
 public:
+    /// which cell to cast out when all candidate cells are taken
+    enum class ReplacePolicy : uint8_t {
+        Ewma,      // largest EWMA (double, `alpha`) of update interval; random if alpha is negative
+        Random,
+        Lru,       // smallest endTime
+        MinPkt,    // smallest pktCnt
+        MinByte,   // smallest byteCnt
+        ShiftEwma, // like Ewma in fixed point, alpha = 2^-alphaShift
+        ProbDecay, // HeavyKeeper: the weakest cell decays with probability decayBase^-strength
+    };
+
     struct Config {
         int rowCnt; // using hash value as index to find which row each flow belong to
         int colCnt; // how many cells for each hash value
         microseconds ttl;
         double alpha; // if negative, replace policy is random
         bool diffHashFunc;
+        ReplacePolicy policy = ReplacePolicy::Ewma;
+        int alphaShift = 2;
+        double decayBase = 1.08; // > 1; only used to precompute integer decay thresholds
+        ResizePolicy resize;     // if enabled, rowCnt doubles or halves online
     };
 
     MultiLevelTable(const Config &config);
@@ -23,23 +45,71 @@ public:
         m_statsEnabled = false;
         m_statsBeginTs = ts;
     }
-    void PrintStats() const;
+    void PrintStats(std::ostream &out = std::cout) const;
+    void PrintEpochCsv(std::ostream &out) const;
+    TableCounters GetCounters() const;
+
+    /// Full table state (cells, counters, RNG, stats flags, epochs) so that
+    /// tables differing only in ttl or policy parameters can resume from it.
+    /// Elastic tables are not supported.
+    bool Snapshot(TableSnapshot &snapshot) const;
+    /// false unless the snapshot was taken from a table with the same
+    /// rowCnt, colCnt, diffHashFunc and policy
+    bool Restore(const TableSnapshot &snapshot);
+
+    /// canonical config serialization, e.g. for ResultCache
+    static std::string ConfigKey(const Config &cfg);
+    /// table memory (cells), e.g. for budgeting batch jobs
+    static size_t MemoryBytes(const Config &cfg);
+    /// tables with equal keys can Restore each other's snapshots
+    static std::string SnapshotKey(const Config &cfg);
 
 private:
     struct Cell;
 
+    // replace policies, statically dispatched through DoRecordWith<Policy>
+    struct PolicyBase;
+    struct EwmaPolicy;
+    struct RandomPolicy;
+    struct LruPolicy;
+    struct MinPktPolicy;
+    struct MinBytePolicy;
+    struct ShiftEwmaPolicy;
+    struct ProbDecayPolicy;
+
     const Config m_cfg;
-    std::unique_ptr<Cell[]> m_table;
-    Ptr<UniformRandomVariable> m_random;
+    ReplacePolicy m_policy;
+    int m_rowCnt;
+    std::unique_ptr<ArenaArray<Cell>> m_table;
+    uint64_t m_rngState = 0x9E3779B97F4A7C15ULL; // xorshift, plain state so that snapshots capture it
+    std::vector<uint32_t> m_decayThresholds; // decayBase^-strength scaled to 2^32
 
     nanoseconds m_statsBeginTs{0};
     bool m_statsEnabled = false;
     int m_outputRecordCnt = 0;
     int m_expirCnt = 0;
     int m_castoutCnt = 0;
+    int m_bypassCnt = 0; // ProbDecay: new flows not admitted
+
+    EpochSeries m_epochs;
+    uint32_t m_occupancy = 0;
+
+    // while resizing, rows below m_migrateCursor already live in m_nextTable
+    ResizeState m_resizeState;
+    std::unique_ptr<ArenaArray<Cell>> m_nextTable;
+    int m_nextRowCnt = 0;
+    int m_migrateCursor = 0;
 
     Cell& CellAt(int row, int col);
+    Cell& Locate(uint32_t hash, int col);
+    void CheckResize(nanoseconds now);
+    void MigrateStep();
     void OutputRecord(Cell &cell);
+    uint64_t NextRandom();
+    std::string PolicyLabel() const;
+
+    template <class Policy>
+    void DoRecordWith(const TcpPktMetadata &pktMeta);
 };
 
 
@@ -50,7 +120,8 @@ struct MultiLevelTable::Cell {
     uint32_t pktCnt = 0;
     uint32_t byteCnt = 0;
 
-    uint32_t updateInterval = 0;
+    /// update interval for Ewma/ShiftEwma, strength for ProbDecay
+    uint32_t policyState = 0;
 
     Cell() { flow.proto = 0; }
 
@@ -62,6 +133,6 @@ struct MultiLevelTable::Cell {
         flow.proto = 0;
         pktCnt = 0;
         byteCnt = 0;
-        updateInterval = 0;
+        policyState = 0;
     }
 };
\ No newline at end of file
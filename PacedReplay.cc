@@ -0,0 +1,70 @@
+#include "PacedReplay.h"
+
+#include <algorithm>
+#include <cmath>
+
+/// @brief Whether packets arriving `speedup` times faster than the trace
+/// would ever wait more than `maxQueueDelay` (Lindley recursion).
+/// Latencies are clamped to `latencyCap`, so that a rare preemption of the
+/// replay thread does not decide the result.
+static bool IsSustainable(const std::vector<TcpPktMetadata> &pkts,
+                          const std::vector<nanoseconds> &latencies,
+                          nanoseconds latencyCap,
+                          double speedup, nanoseconds maxQueueDelay) {
+    double wait = 0;
+    for (size_t i = 1; i < pkts.size(); i++) {
+        double gap = (pkts[i].timestamp - pkts[i - 1].timestamp).count() / speedup;
+        double service = std::min(latencies[i - 1], latencyCap).count();
+        wait = std::max(0.0, wait + service - gap);
+        if (wait > maxQueueDelay.count()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FinishPacedReplay(PacedReplayResult &result,
+                       const std::vector<TcpPktMetadata> &pkts,
+                       const std::vector<nanoseconds> &latencies,
+                       nanoseconds maxQueueDelay) {
+    std::vector<nanoseconds> sorted{latencies};
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) {
+        return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+    };
+    result.latencyP50 = percentile(0.5);
+    result.latencyP99 = percentile(0.99);
+    result.latencyP999 = percentile(0.999);
+    result.latencyMax = sorted.back();
+
+    // binary search in log space
+    double lo = 1e-3;
+    double hi = 1e6;
+    if (!IsSustainable(pkts, latencies, result.latencyP999, lo, maxQueueDelay)) {
+        hi = lo = 0;
+    }
+    for (int iter = 0; iter < 40 && hi / lo > 1.01; iter++) {
+        double mid = std::sqrt(lo * hi);
+        if (IsSustainable(pkts, latencies, result.latencyP999, mid, maxQueueDelay)) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    result.maxSustainableSpeedup = lo;
+}
+
+void PacedReplayResult::Print() const {
+    std::cout << "paced x" << speedup
+            << ": pkts=" << pktCnt
+            << ", trace=" << std::chrono::duration_cast<microseconds>(traceDuration)
+            << ", wall=" << std::chrono::duration_cast<microseconds>(wallDuration)
+            << ", maxLag=" << std::chrono::duration_cast<microseconds>(maxLag)
+            << std::endl;
+    std::cout << "latency p50=" << latencyP50.count() << "ns"
+            << ", p99=" << latencyP99.count() << "ns"
+            << ", p99.9=" << latencyP999.count() << "ns"
+            << ", max=" << latencyMax.count() << "ns"
+            << ", maxSustainableSpeedup=" << maxSustainableSpeedup
+            << std::endl;
+}
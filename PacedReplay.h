@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include "TcpPktMeta.h"
+
+/// @brief Latency and headroom of one table replayed against the wall clock.
+struct PacedReplayResult {
+    double speedup;
+    int64_t pktCnt = 0;
+    nanoseconds traceDuration{0};
+    nanoseconds wallDuration{0};
+
+    /// per-packet DoRecord time
+    nanoseconds latencyP50{0};
+    nanoseconds latencyP99{0};
+    nanoseconds latencyP999{0};
+    nanoseconds latencyMax{0};
+
+    /// how late packets were handed to DoRecord vs their paced arrival
+    nanoseconds maxLag{0};
+
+    /// largest speed-up whose queueing delay stays within the bound,
+    /// estimated from the measured per-packet latencies capped at p99.9
+    double maxSustainableSpeedup = 0;
+
+    void Print() const;
+};
+
+/// @brief Summarize per-packet latencies and find the max sustainable speed-up.
+/// @param latencies DoRecord time of each packet in `pkts`
+void FinishPacedReplay(PacedReplayResult &result,
+                       const std::vector<TcpPktMetadata> &pkts,
+                       const std::vector<nanoseconds> &latencies,
+                       nanoseconds maxQueueDelay);
+
+/// @brief Feed `pkts` to `tbl.DoRecord` paced by their timestamp deltas,
+/// `speedup` times faster than the trace. Busy-waits between packets, so run
+/// it pinned to a dedicated core.
+/// @param maxQueueDelay queueing delay beyond which a queue is considered building up
+template <class Table>
+PacedReplayResult PacedReplay(Table &tbl, const std::vector<TcpPktMetadata> &pkts,
+                              double speedup, nanoseconds maxQueueDelay)
+{
+    using Clock = std::chrono::steady_clock;
+    PacedReplayResult result;
+    result.speedup = speedup;
+    result.pktCnt = pkts.size();
+    if (pkts.empty()) {
+        return result;
+    }
+
+    std::vector<nanoseconds> latencies(pkts.size());
+    nanoseconds traceBeginTs = pkts.front().timestamp;
+    auto wallBegin = Clock::now();
+    for (size_t i = 0; i < pkts.size(); i++) {
+        auto target = wallBegin + std::chrono::duration_cast<Clock::duration>(
+            (pkts[i].timestamp - traceBeginTs) / speedup);
+        auto begin = Clock::now();
+        while (begin < target) {
+            begin = Clock::now();
+        }
+        tbl.DoRecord(pkts[i]);
+        auto end = Clock::now();
+        latencies[i] = end - begin;
+        result.maxLag = std::max(result.maxLag, nanoseconds{begin - target});
+    }
+    result.wallDuration = Clock::now() - wallBegin;
+    result.traceDuration = pkts.back().timestamp - traceBeginTs;
+
+    FinishPacedReplay(result, pkts, latencies, maxQueueDelay);
+    return result;
+}
@@ -0,0 +1,366 @@
+#include "PcapReader.h"
+
+#include <algorithm>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr uint32_t PcapMagicUs = 0xa1b2c3d4;
+static constexpr uint32_t PcapMagicNs = 0xa1b23c4d;
+static constexpr uint32_t PcapngSectionHeader = 0x0a0d0d0a;
+static constexpr uint32_t PcapngByteOrderMagic = 0x1a2b3c4d;
+static constexpr uint32_t PcapngInterfaceDesc = 1;
+static constexpr uint32_t PcapngPacket = 2; // obsolete, still written by old tools
+static constexpr uint32_t PcapngSimplePacket = 3;
+static constexpr uint32_t PcapngEnhancedPacket = 6;
+
+enum LinkType : uint16_t {
+    LinkEthernet = 1,
+    LinkPpp = 9,
+    LinkRaw = 101,
+    LinkLinuxSll = 113,
+    LinkIpv4 = 228,
+};
+
+static uint16_t Be16(const uint8_t *p) { return (p[0] << 8) | p[1]; }
+static uint32_t Be32(const uint8_t *p) { return ((uint32_t)Be16(p) << 16) | Be16(p + 2); }
+
+
+enum class DecodeResult { Ok, NonTcp, Truncated, Malformed };
+
+/// parse link/IPv4/TCP headers of one captured frame in place
+static DecodeResult DecodeFrame(const uint8_t *p, uint32_t capLen, uint16_t linkType,
+                                TcpPktMetadata &meta) {
+    uint32_t off = 0;
+    uint16_t etherType = 0x0800;
+    switch (linkType) {
+    case LinkEthernet:
+        off = 14;
+        if (capLen < off) return DecodeResult::Truncated;
+        etherType = Be16(p + 12);
+        while (etherType == 0x8100 || etherType == 0x88a8) { // VLAN / QinQ tag
+            off += 4;
+            if (capLen < off) return DecodeResult::Truncated;
+            etherType = Be16(p + off - 2);
+        }
+        break;
+    case LinkPpp:
+        if (capLen >= 2 && p[0] == 0xff && p[1] == 0x03) { // HDLC address/control
+            off = 2;
+        }
+        off += 2;
+        if (capLen < off) return DecodeResult::Truncated;
+        etherType = (Be16(p + off - 2) == 0x0021) ? 0x0800 : 0;
+        break;
+    case LinkLinuxSll:
+        off = 16;
+        if (capLen < off) return DecodeResult::Truncated;
+        etherType = Be16(p + 14);
+        break;
+    case LinkRaw:
+    case LinkIpv4:
+        break;
+    default:
+        return DecodeResult::NonTcp;
+    }
+    if (etherType != 0x0800) {
+        return DecodeResult::NonTcp;
+    }
+
+    const uint8_t *ip = p + off;
+    if (capLen < off + 20) return DecodeResult::Truncated;
+    if ((ip[0] >> 4) != 4) return DecodeResult::NonTcp;
+    uint32_t ipHdrLen = (ip[0] & 0xf) * 4;
+    if (ipHdrLen < 20) return DecodeResult::Malformed;
+    if (ip[9] != TcpL4Protocol::PROT_NUMBER) return DecodeResult::NonTcp;
+    if ((Be16(ip + 6) & 0x1fff) != 0) return DecodeResult::NonTcp; // non-first fragment
+
+    const uint8_t *tcp = ip + ipHdrLen;
+    if (capLen < off + ipHdrLen + 14) return DecodeResult::Truncated;
+    uint32_t tcpHdrLen = (tcp[12] >> 4) * 4;
+    uint32_t ipTotalLen = Be16(ip + 2);
+
+    meta.flow.srcAddr = Be32(ip + 12);
+    meta.flow.dstAddr = Be32(ip + 16);
+    meta.flow.proto = ip[9];
+    meta.flow.srcPort = Be16(tcp);
+    meta.flow.dstPort = Be16(tcp + 2);
+    meta.tcpFlags = tcp[13];
+    meta.payloadSize = (ipTotalLen > ipHdrLen + tcpHdrLen) ? ipTotalLen - ipHdrLen - tcpHdrLen : 0;
+    return DecodeResult::Ok;
+}
+
+
+bool PcapReader::IsCaptureFile(const std::string &filename) {
+    auto endsWith = [&filename](const std::string &suffix) {
+        return filename.size() >= suffix.size()
+            && filename.compare(filename.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    return endsWith(".pcap") || endsWith(".pcapng");
+}
+
+PcapReader::PcapReader(const std::string &filename, int decodeThreadCnt)
+    : m_decodeThreadCnt{std::max(decodeThreadCnt, 1)}
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= 24) {
+        void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            m_data = static_cast<const uint8_t*>(addr);
+            m_size = st.st_size;
+            madvise(addr, m_size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+
+    if (m_data != nullptr && !ParsePcapHeader()) {
+        std::cout << filename << " is neither pcap nor pcapng" << std::endl;
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = nullptr;
+    }
+}
+
+PcapReader::~PcapReader() {
+    if (m_data != nullptr) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+}
+
+uint16_t PcapReader::Read16(const uint8_t *p) const {
+    uint16_t v;
+    std::copy(p, p + 2, reinterpret_cast<uint8_t*>(&v));
+    return m_swapped ? __builtin_bswap16(v) : v;
+}
+
+uint32_t PcapReader::Read32(const uint8_t *p) const {
+    uint32_t v;
+    std::copy(p, p + 4, reinterpret_cast<uint8_t*>(&v));
+    return m_swapped ? __builtin_bswap32(v) : v;
+}
+
+bool PcapReader::ParsePcapHeader() {
+    m_swapped = false;
+    uint32_t magic = Read32(m_data);
+    if (magic == PcapngSectionHeader) {
+        m_isPcapng = true;
+        return true; // the section header is parsed as a regular block
+    }
+    if (magic == __builtin_bswap32(PcapMagicUs) || magic == __builtin_bswap32(PcapMagicNs)) {
+        m_swapped = true;
+        magic = __builtin_bswap32(magic);
+    }
+    if (magic != PcapMagicUs && magic != PcapMagicNs) {
+        return false;
+    }
+    m_nanoTs = (magic == PcapMagicNs);
+    m_linkType = Read32(m_data + 20) & 0xffff;
+    m_offset = 24;
+    return true;
+}
+
+uint64_t PcapReader::ToNs(uint64_t ts, uint8_t tsResol) const {
+    if (tsResol & 0x80) {
+        // negative power of 2
+        return (uint64_t)(((unsigned __int128)ts * 1'000'000'000) >> (tsResol & 0x7f));
+    }
+    uint64_t ns = ts;
+    for (int e = tsResol; e < 9; e++) ns *= 10;
+    for (int e = tsResol; e > 9; e--) ns /= 10;
+    return ns;
+}
+
+void PcapReader::ScanPcap(std::vector<RawRecord> &out) {
+    while (out.size() < WindowSize && m_offset + 16 <= m_size) {
+        const uint8_t *hdr = m_data + m_offset;
+        uint32_t capLen = Read32(hdr + 8);
+        if (m_offset + 16 + capLen > m_size) {
+            m_truncatedCnt++; // capture cut in the middle of a record
+            m_offset = m_size;
+            break;
+        }
+        uint64_t sec = Read32(hdr);
+        uint64_t frac = Read32(hdr + 4);
+        RawRecord rec;
+        rec.data = hdr + 16;
+        rec.capLen = capLen;
+        rec.origLen = Read32(hdr + 12);
+        rec.tsNs = sec * 1'000'000'000 + (m_nanoTs ? frac : frac * 1000);
+        rec.linkType = m_linkType;
+        rec.portId = 0;
+        out.push_back(rec);
+        m_offset += 16 + capLen;
+    }
+}
+
+void PcapReader::ParseSectionHeader(const uint8_t *block) {
+    m_swapped = false;
+    if (Read32(block + 8) != PcapngByteOrderMagic) {
+        m_swapped = true;
+    }
+    m_interfaces.clear();
+}
+
+void PcapReader::ParseInterface(const uint8_t *block, uint32_t blockLen) {
+    Interface iface{Read16(block + 8), 6};
+    // options start after linktype(2), reserved(2), snaplen(4)
+    const uint8_t *opt = block + 16;
+    const uint8_t *end = block + blockLen - 4;
+    while (opt + 4 <= end) {
+        uint16_t code = Read16(opt);
+        uint16_t len = Read16(opt + 2);
+        if (code == 0) {
+            break; // opt_endofopt
+        }
+        if (code == 9 && len == 1) { // if_tsresol
+            iface.tsResol = opt[4];
+        }
+        opt += 4 + (len + 3) / 4 * 4;
+    }
+    m_interfaces.push_back(iface);
+}
+
+void PcapReader::ScanPcapng(std::vector<RawRecord> &out) {
+    while (out.size() < WindowSize && m_offset + 12 <= m_size) {
+        const uint8_t *block = m_data + m_offset;
+        uint32_t type = Read32(block);
+        if (type == PcapngSectionHeader) {
+            // byte order may change per section, so fix it before reading the length
+            ParseSectionHeader(block);
+        }
+        uint32_t blockLen = Read32(block + 4);
+        if (blockLen < 12 || m_offset + blockLen > m_size) {
+            m_truncatedCnt++;
+            m_offset = m_size;
+            break;
+        }
+        m_offset += blockLen;
+
+        RawRecord rec;
+        uint32_t ifId = 0;
+        uint64_t ts = 0;
+        bool hasTs = true;
+        if (type == PcapngInterfaceDesc) {
+            ParseInterface(block, blockLen);
+            continue;
+        } else if (type == PcapngEnhancedPacket && blockLen >= 32) {
+            ifId = Read32(block + 8);
+            ts = ((uint64_t)Read32(block + 12) << 32) | Read32(block + 16);
+            rec.capLen = Read32(block + 20);
+            rec.origLen = Read32(block + 24);
+            rec.data = block + 28;
+        } else if (type == PcapngPacket && blockLen >= 32) {
+            ifId = Read16(block + 8);
+            ts = ((uint64_t)Read32(block + 12) << 32) | Read32(block + 16);
+            rec.capLen = Read32(block + 20);
+            rec.origLen = Read32(block + 24);
+            rec.data = block + 28;
+        } else if (type == PcapngSimplePacket && blockLen >= 16) {
+            rec.origLen = Read32(block + 8);
+            rec.capLen = std::min(rec.origLen, blockLen - 16);
+            rec.data = block + 12;
+            hasTs = false;
+        } else {
+            continue; // name resolution, statistics, custom blocks, ...
+        }
+
+        if (ifId >= m_interfaces.size() || rec.data + rec.capLen > block + blockLen - 4) {
+            m_truncatedCnt++;
+            continue;
+        }
+        const Interface &iface = m_interfaces[ifId];
+        rec.linkType = iface.linkType;
+        rec.portId = ifId;
+        // simple packet blocks carry no timestamp: reuse the previous one
+        rec.tsNs = hasTs ? ToNs(ts, iface.tsResol) : m_lastTsNs;
+        m_lastTsNs = rec.tsNs;
+        out.push_back(rec);
+    }
+}
+
+bool PcapReader::NextBatch(std::vector<TcpPktMetadata> &batch) {
+    batch.clear();
+    if (m_data == nullptr || m_offset >= m_size) {
+        return false;
+    }
+
+    std::vector<RawRecord> records;
+    records.reserve(std::min(WindowSize, (m_size - m_offset) / 16 + 1));
+    if (m_isPcapng) {
+        ScanPcapng(records);
+    } else {
+        ScanPcap(records);
+    }
+    if (records.empty()) {
+        return m_offset < m_size;
+    }
+    if (!m_hasFirstTs) {
+        m_firstTsNs = records.front().tsNs;
+        m_hasFirstTs = true;
+    }
+    m_recordCnt += records.size();
+
+    struct Part {
+        std::vector<TcpPktMetadata> pkts;
+        int64_t nonTcpCnt = 0;
+        int64_t truncatedCnt = 0;
+        int64_t malformedCnt = 0;
+    };
+    int partCnt = std::min<size_t>(m_decodeThreadCnt, records.size());
+    std::vector<Part> parts(partCnt);
+    auto decode = [&](int partIdx) {
+        size_t begin = records.size() * partIdx / partCnt;
+        size_t end = records.size() * (partIdx + 1) / partCnt;
+        Part &part = parts[partIdx];
+        part.pkts.reserve(end - begin);
+        for (size_t i = begin; i < end; i++) {
+            const RawRecord &rec = records[i];
+            TcpPktMetadata meta;
+            switch (DecodeFrame(rec.data, rec.capLen, rec.linkType, meta)) {
+            case DecodeResult::Ok:
+                // records may be slightly out of order, never let one go below zero
+                meta.timestamp = std::max(0ns, 1s + nanoseconds{(int64_t)rec.tsNs - (int64_t)m_firstTsNs});
+                meta.phyPktSize = rec.origLen;
+                meta.portId = rec.portId;
+                part.pkts.push_back(meta);
+                break;
+            case DecodeResult::NonTcp:
+                part.nonTcpCnt++;
+                break;
+            case DecodeResult::Truncated:
+                part.truncatedCnt++;
+                break;
+            case DecodeResult::Malformed:
+                part.malformedCnt++;
+                break;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < partCnt; i++) {
+        workers.emplace_back(decode, i);
+    }
+    decode(0);
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    for (auto &part : parts) {
+        batch.insert(batch.end(), part.pkts.begin(), part.pkts.end());
+        m_nonTcpCnt += part.nonTcpCnt;
+        m_truncatedCnt += part.truncatedCnt;
+        m_malformedCnt += part.malformedCnt;
+    }
+    // release pages already decoded, captures may be far larger than memory
+    size_t releaseEnd = m_offset & ~(size_t)4095;
+    if (releaseEnd > m_releasedOffset) {
+        madvise(const_cast<uint8_t*>(m_data) + m_releasedOffset, releaseEnd - m_releasedOffset, MADV_DONTNEED);
+        m_releasedOffset = releaseEnd;
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "TcpPktMeta.h"
+
+/// @brief Reads TCP packets of a pcap or pcapng capture as TcpPktMetadata.
+/// The file is mmapped and headers are parsed in place. Record boundaries
+/// are found by a sequential scan, then each window of records is decoded
+/// by several threads in parallel.
+/// Timestamps are rebased so that the first packet is at 1s, like the
+/// traffic generated by GenPktTrace. In pcapng, the interface a packet was
+/// captured on becomes its port ID.
+class PcapReader {
+public:
+    static constexpr size_t WindowSize = 1 << 20; // records decoded per NextBatch
+
+    PcapReader(const std::string &filename, int decodeThreadCnt);
+    ~PcapReader();
+    PcapReader(const PcapReader&) = delete;
+    PcapReader& operator= (const PcapReader&) = delete;
+
+    bool IsOpen() const { return m_data != nullptr; }
+
+    /// @brief Decode the next window of records into `batch` (TCP packets only).
+    /// @return false once the whole capture has been consumed
+    bool NextBatch(std::vector<TcpPktMetadata> &batch);
+
+    int64_t GetRecordCnt() const { return m_recordCnt; }
+    int64_t GetNonTcpCnt() const { return m_nonTcpCnt; }
+    /// records whose snaplen cut into the headers we need
+    int64_t GetTruncatedCnt() const { return m_truncatedCnt; }
+    /// IPv4 headers with an impossible length (IHL < 5)
+    int64_t GetMalformedCnt() const { return m_malformedCnt; }
+
+    static bool IsCaptureFile(const std::string &filename);
+
+private:
+    struct RawRecord {
+        const uint8_t *data;
+        uint32_t capLen;
+        uint32_t origLen;
+        uint64_t tsNs;
+        uint16_t linkType;
+        uint16_t portId;
+    };
+    struct Interface {
+        uint16_t linkType;
+        uint8_t tsResol; // raw if_tsresol option
+    };
+
+    const uint8_t *m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_offset = 0;
+    size_t m_releasedOffset = 0;
+    int m_decodeThreadCnt;
+
+    bool m_isPcapng = false;
+    bool m_swapped = false;
+    uint16_t m_linkType = 0;     // pcap only
+    bool m_nanoTs = false;       // pcap only
+    std::vector<Interface> m_interfaces; // pcapng only, current section
+    uint64_t m_lastTsNs = 0;
+    uint64_t m_firstTsNs = 0;
+    bool m_hasFirstTs = false;
+
+    int64_t m_recordCnt = 0;
+    int64_t m_nonTcpCnt = 0;
+    int64_t m_truncatedCnt = 0;
+    int64_t m_malformedCnt = 0;
+
+    uint16_t Read16(const uint8_t *p) const;
+    uint32_t Read32(const uint8_t *p) const;
+    bool ParsePcapHeader();
+    void ScanPcap(std::vector<RawRecord> &out);
+    void ScanPcapng(std::vector<RawRecord> &out);
+    void ParseSectionHeader(const uint8_t *block);
+    void ParseInterface(const uint8_t *block, uint32_t blockLen);
+    uint64_t ToNs(uint64_t ts, uint8_t tsResol) const;
+};
@@ -0,0 +1,152 @@
+#include "QuantileSketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <string>
+
+
+DDSketch::DDSketch(double relativeAccuracy, int maxBins)
+    : m_relativeAccuracy{relativeAccuracy},
+    m_maxBins{std::max(1, maxBins)},
+    m_logGamma{std::log((1 + relativeAccuracy) / (1 - relativeAccuracy))}
+{}
+
+int DDSketch::BinIndex(double value) const {
+    return (int)std::ceil(std::log(value) / m_logGamma);
+}
+
+void DDSketch::AddToBin(int idx, uint64_t cnt) {
+    if (m_bins.empty()) {
+        m_offset = idx;
+        m_bins.push_back(0);
+    } else if (idx < m_offset) {
+        // past full width, values below the lowest bin we can open are collapsed into it
+        int newOffset = std::max(idx, m_offset + (int)m_bins.size() - m_maxBins);
+        if (newOffset < m_offset) {
+            m_bins.insert(m_bins.begin(), m_offset - newOffset, 0);
+            m_offset = newOffset;
+        }
+    } else if (idx >= m_offset + (int)m_bins.size()) {
+        m_bins.resize(idx - m_offset + 1, 0);
+        if ((int)m_bins.size() > m_maxBins) {
+            int collapsed = m_bins.size() - m_maxBins;
+            uint64_t lowCnt = 0;
+            for (int i = 0; i < collapsed; i++) {
+                lowCnt += m_bins[i];
+            }
+            m_bins.erase(m_bins.begin(), m_bins.begin() + collapsed);
+            m_bins.front() += lowCnt;
+            m_offset += collapsed;
+        }
+    }
+    m_bins[std::max(idx, m_offset) - m_offset] += cnt;
+}
+
+void DDSketch::Add(double value, uint64_t cnt) {
+    if (cnt == 0) {
+        return;
+    }
+    if (m_count == 0) {
+        m_min = m_max = value;
+    } else {
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+    m_count += cnt;
+    m_sum += value * cnt;
+    if (value <= 0) {
+        m_zeroCnt += cnt;
+    } else {
+        AddToBin(BinIndex(value), cnt);
+    }
+}
+
+void DDSketch::Merge(const DDSketch &other) {
+    if (other.m_count == 0) {
+        return;
+    }
+    if (m_count == 0) {
+        m_min = other.m_min;
+        m_max = other.m_max;
+    } else {
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_zeroCnt += other.m_zeroCnt;
+    // highest bins first, so that collapsing only ever folds the low end
+    for (int i = other.m_bins.size() - 1; i >= 0; i--) {
+        if (other.m_bins[i] > 0) {
+            AddToBin(other.m_offset + i, other.m_bins[i]);
+        }
+    }
+}
+
+double DDSketch::Quantile(double q) const {
+    if (m_count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(std::clamp(q, 0.0, 1.0) * (m_count - 1));
+    if (rank < m_zeroCnt) {
+        return std::min(0.0, m_max);
+    }
+    uint64_t seen = m_zeroCnt;
+    for (size_t i = 0; i < m_bins.size(); i++) {
+        seen += m_bins[i];
+        if (seen > rank) {
+            // the value minimizing relative error over bin (gamma^(k-1), gamma^k]
+            double gamma = std::exp(m_logGamma);
+            double value = 2 * std::pow(gamma, (double)(m_offset + (int)i)) / (gamma + 1);
+            return std::clamp(value, m_min, m_max);
+        }
+    }
+    return m_max;
+}
+
+void DDSketch::PrintSummary(std::ostream &out) const {
+    out << "count=" << m_count
+        << ", mean=" << Mean()
+        << ", p50=" << Quantile(0.5)
+        << ", p90=" << Quantile(0.9)
+        << ", p99=" << Quantile(0.99)
+        << ", p99.9=" << Quantile(0.999)
+        << ", max=" << m_max;
+}
+
+void DDSketch::Write(std::ostream &out) const {
+    out << "DDSketch " << std::setprecision(17)
+        << m_relativeAccuracy << ' ' << m_maxBins << ' '
+        << m_count << ' ' << m_zeroCnt << ' '
+        << m_min << ' ' << m_max << ' ' << m_sum << ' '
+        << m_offset << ' ' << m_bins.size();
+    for (uint64_t cnt : m_bins) {
+        out << ' ' << cnt;
+    }
+    out << std::setprecision(6) << '\n';
+}
+
+std::optional<DDSketch> DDSketch::Read(std::istream &in) {
+    std::string tag;
+    double relativeAccuracy;
+    int maxBins;
+    if (!(in >> tag >> relativeAccuracy >> maxBins) || tag != "DDSketch") {
+        return {};
+    }
+    DDSketch sketch{relativeAccuracy, maxBins};
+    size_t binCnt;
+    if (!(in >> sketch.m_count >> sketch.m_zeroCnt >> sketch.m_min >> sketch.m_max
+             >> sketch.m_sum >> sketch.m_offset >> binCnt)) {
+        return {};
+    }
+    sketch.m_bins.resize(binCnt);
+    for (auto &cnt : sketch.m_bins) {
+        if (!(in >> cnt)) {
+            return {};
+        }
+    }
+    return sketch;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <vector>
+
+/// @brief DDSketch: streaming quantiles with bounded relative error.
+/// A value v lands in bin ceil(log_gamma(v)), gamma = (1+a)/(1-a), so every
+/// quantile is within a relative error `a` of the true value. At most
+/// `maxBins` consecutive bins are kept; beyond that the lowest bins are
+/// collapsed, which only degrades the smallest quantiles.
+/// Sketches with the same parameters merge exactly, e.g. across sharded runs.
+class DDSketch {
+public:
+    explicit DDSketch(double relativeAccuracy = 0.01, int maxBins = 2048);
+
+    /// values <= 0 are counted apart, as exact zeros
+    void Add(double value, uint64_t cnt = 1);
+    /// `other` must have the same relative accuracy
+    void Merge(const DDSketch &other);
+
+    /// @param q in [0, 1]
+    double Quantile(double q) const;
+    uint64_t Count() const { return m_count; }
+    double Min() const { return m_min; }
+    double Max() const { return m_max; }
+    double Mean() const { return m_count ? m_sum / m_count : 0; }
+
+    /// one line: count, mean, p50, p90, p99, p99.9, max
+    void PrintSummary(std::ostream &out) const;
+
+    void Write(std::ostream &out) const;
+    static std::optional<DDSketch> Read(std::istream &in);
+
+private:
+    double m_relativeAccuracy;
+    int m_maxBins;
+    double m_logGamma;
+
+    std::vector<uint64_t> m_bins; // bin m_offset + i
+    int m_offset = 0;
+    uint64_t m_zeroCnt = 0;
+    uint64_t m_count = 0;
+    double m_min = 0;
+    double m_max = 0;
+    double m_sum = 0;
+
+    int BinIndex(double value) const;
+    void AddToBin(int idx, uint64_t cnt);
+};
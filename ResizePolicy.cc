@@ -0,0 +1,78 @@
+#include "ResizePolicy.h"
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+
+
+int ResizePolicy::NextRows(int rows, size_t cellCnt, uint32_t occupancy,
+                           uint32_t windowPkts, uint32_t windowEvicts) const {
+    double metric = (trigger == Trigger::Occupancy)
+                  ? (double)occupancy / cellCnt
+                  : (double)windowEvicts / windowPkts;
+    if (metric > growThreshold && (int64_t)rows * 2 <= maxRows) {
+        return rows * 2;
+    }
+    // halving needs an even row count, so that rows r and r + rows/2 merge
+    if (metric < shrinkThreshold && rows % 2 == 0 && rows / 2 >= minRows) {
+        return rows / 2;
+    }
+    return rows;
+}
+
+std::string ResizePolicy::Key() const {
+    std::ostringstream oss;
+    oss << ToString(trigger)
+        << " grow=" << std::hexfloat << growThreshold
+        << " shrink=" << shrinkThreshold << std::defaultfloat
+        << " rows=[" << minRows << "," << maxRows << "]"
+        << " check=" << checkPkts
+        << " step=" << migrateStep;
+    return oss.str();
+}
+
+const char* ToString(ResizePolicy::Trigger trigger) {
+    switch (trigger) {
+    case ResizePolicy::Trigger::EvictRate: return "evictRate";
+    case ResizePolicy::Trigger::Occupancy: return "occupancy";
+    }
+    return "?";
+}
+
+
+int ResizeState::Decide(const ResizePolicy &policy, int rows, size_t cellCnt, uint32_t occupancy, int64_t now) {
+    int next = policy.NextRows(rows, cellCnt, occupancy, windowPkts, windowEvicts);
+    ResetWindow();
+    if (next < rows && m_shrinkHold > 0) {
+        m_shrinkHold--;
+        return rows;
+    }
+    if (next == rows) {
+        return rows;
+    }
+    if (next > rows) {
+        growCnt++;
+        if (m_lastWasShrink) {
+            m_shrinkBackoff = std::max(1, m_shrinkBackoff * 2);
+            m_shrinkHold = m_shrinkBackoff;
+        }
+    } else {
+        shrinkCnt++;
+    }
+    m_lastWasShrink = next < rows;
+    history.push_back({now, next});
+    return next;
+}
+
+void ResizeState::PrintStats(std::ostream &out, int rows) const {
+    out << "resizes: grow=" << growCnt
+        << ", shrink=" << shrinkCnt
+        << ", mergeFlushes=" << evictCnt
+        << ", finalRows=" << rows
+        << std::endl;
+    out << "resize history (ms:rows):";
+    for (const auto &[ts, r] : history) {
+        out << " " << ts / 1'000'000.0 << ":" << r;
+    }
+    out << std::endl;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// @brief When an elastic table doubles or halves its rows.
+/// Checked once every `checkPkts` packets; the switch to the new size is
+/// then spread over later packets, `migrateStep` old rows per DoRecord.
+struct ResizePolicy {
+    enum class Trigger {
+        EvictRate, // collisions / cast-outs per packet of the last window
+        Occupancy, // valid cells / all cells
+    };
+
+    bool enabled = false;
+    Trigger trigger = Trigger::EvictRate;
+    double growThreshold = 0.01;    // grow when the metric is above
+    double shrinkThreshold = 0.001; // shrink when the metric is below
+    int minRows = 0;
+    int maxRows = 0;
+    uint32_t checkPkts = 1 << 16;
+    int migrateStep = 4;
+
+    /// rows after a check window, `rows` if the table should stay as is
+    int NextRows(int rows, size_t cellCnt, uint32_t occupancy,
+                 uint32_t windowPkts, uint32_t windowEvicts) const;
+
+    /// canonical serialization for table config keys
+    std::string Key() const;
+};
+
+const char* ToString(ResizePolicy::Trigger trigger);
+
+
+/// @brief Window counters and history of an elastic table
+struct ResizeState {
+    uint32_t windowPkts = 0;
+    uint32_t windowEvicts = 0;
+    int growCnt = 0;
+    int shrinkCnt = 0;
+    int evictCnt = 0; // records flushed because two rows merged on a shrink
+    std::vector<std::pair<int64_t, int>> history; // (ns, rows) when a resize started
+
+    /// Closes the check window and returns the rows to resize to, `rows` to
+    /// stay. A grow right after a shrink doubles how many windows the next
+    /// shrink waits, so that a table doesn't flap between two sizes.
+    int Decide(const ResizePolicy &policy, int rows, size_t cellCnt, uint32_t occupancy, int64_t now);
+    /// call once the table has moved over, so that the next window only sees the new size
+    void ResetWindow() {
+        windowPkts = 0;
+        windowEvicts = 0;
+    }
+
+    void PrintStats(std::ostream &out, int rows) const;
+
+private:
+    bool m_lastWasShrink = false;
+    int m_shrinkBackoff = 0;
+    int m_shrinkHold = 0;
+};
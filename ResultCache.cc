@@ -0,0 +1,104 @@
+#include "ResultCache.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include "ns3/hash.h"
+
+namespace fs = std::filesystem;
+using namespace ns3;
+
+static std::string ToHex(uint64_t x) {
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << x;
+    return oss.str();
+}
+
+ResultCache::ResultCache(const std::string &cacheDir, const std::string &traceFilename, const std::string &runKey) {
+    if (cacheDir.empty() || !fs::exists(traceFilename)) {
+        return;
+    }
+    std::error_code ec;
+    fs::create_directories(cacheDir, ec);
+    if (ec) {
+        std::cout << "Failed to create " << cacheDir << ", result cache disabled" << std::endl;
+        return;
+    }
+    std::string runKeyVer = runKey + " v" + std::to_string(FormatVersion);
+    m_dir = fs::path{cacheDir} / (ToHex(HashTraceFile(traceFilename, cacheDir)) + "-" + ToHex(Hash64(runKeyVer)));
+    fs::create_directories(m_dir, ec);
+    if (ec) {
+        m_dir.clear();
+    }
+}
+
+/// Content hash of the trace, memoized by (path, size, mtime) so that
+/// unchanged multi-GB traces are only read once.
+uint64_t ResultCache::HashTraceFile(const std::string &traceFilename, const fs::path &cacheDir) {
+    auto absPath = fs::absolute(traceFilename).string();
+    auto size = fs::file_size(traceFilename);
+    auto mtime = fs::last_write_time(traceFilename).time_since_epoch().count();
+    fs::path memoPath = cacheDir / ("trace-" + ToHex(Hash64(absPath)) + ".hash");
+
+    std::ifstream memoIn{memoPath};
+    uintmax_t memoSize;
+    int64_t memoMtime;
+    std::string memoHash;
+    if (memoIn >> memoSize >> memoMtime >> memoHash && memoSize == size && memoMtime == mtime) {
+        return std::stoull(memoHash, nullptr, 16);
+    }
+
+    Hasher hasher{Create<Hash::Function::Murmur3>()};
+    hasher.clear();
+    std::ifstream in{traceFilename, std::ios::binary};
+    std::vector<char> buf(1 << 20);
+    uint64_t hash = 0;
+    while (in) {
+        in.read(buf.data(), buf.size());
+        if (in.gcount() > 0) {
+            hash = hasher.GetHash64(buf.data(), in.gcount()); // incremental, no clear()
+        }
+    }
+
+    std::ofstream memoOut{memoPath};
+    memoOut << size << ' ' << mtime << ' ' << ToHex(hash) << '\n';
+    return hash;
+}
+
+fs::path ResultCache::EntryPath(const std::string &configKey) const {
+    return m_dir / (ToHex(Hash64(configKey)) + ".txt");
+}
+
+std::optional<std::string> ResultCache::Lookup(const std::string &configKey) const {
+    if (!IsEnabled()) {
+        return {};
+    }
+    std::ifstream in{EntryPath(configKey)};
+    std::string storedKey;
+    if (!std::getline(in, storedKey) || storedKey != configKey) {
+        return {}; // miss, or a hash collision
+    }
+    std::ostringstream report;
+    report << in.rdbuf();
+    return report.str();
+}
+
+void ResultCache::Store(const std::string &configKey, const std::string &report) const {
+    if (!IsEnabled()) {
+        return;
+    }
+    // write then rename, so that an interrupted sweep never leaves half an entry
+    fs::path path = EntryPath(configKey);
+    fs::path tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream out{tmpPath};
+        out << configKey << '\n' << report;
+        if (!out) {
+            return;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmpPath, path, ec);
+}
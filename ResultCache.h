@@ -0,0 +1,30 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+/// @brief On-disk cache of per-table sweep reports.
+/// Entries live under `cacheDir/<trace content hash>-<run key hash>/` and are
+/// keyed by a canonical serialization of the table config, so a sweep only
+/// replays the trace for configs it has not seen with this trace before.
+class ResultCache {
+public:
+    /// bump whenever table behavior or the report format changes
+    static constexpr int FormatVersion = 7;
+
+    /// @param cacheDir if empty, the cache is disabled
+    /// @param runKey everything besides the trace and table config that affects results
+    ResultCache(const std::string &cacheDir, const std::string &traceFilename, const std::string &runKey);
+
+    bool IsEnabled() const { return !m_dir.empty(); }
+
+    std::optional<std::string> Lookup(const std::string &configKey) const;
+    void Store(const std::string &configKey, const std::string &report) const;
+
+private:
+    std::filesystem::path m_dir;
+
+    std::filesystem::path EntryPath(const std::string &configKey) const;
+    static uint64_t HashTraceFile(const std::string &traceFilename, const std::filesystem::path &cacheDir);
+};
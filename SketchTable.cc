@@ -0,0 +1,247 @@
+#include "SketchTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "TcpPktMeta.h"
+
+
+void FlowSizeTruth::DoRecord(const TcpPktMetadata &pktMeta) {
+    if (pktMeta.timestamp >= m_statsBeginTs) {
+        m_flowSizes[pktMeta.flow]++;
+    }
+}
+
+
+/// murmur3's 32-bit finalizer; h1 + i*h2 alone has a low bit alternating by row
+static inline uint32_t Mix32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85ebca6bU;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35U;
+    x ^= x >> 16;
+    return x;
+}
+
+SketchHashes::SketchHashes(const FlowTuple &flow, uint32_t width, int depth) {
+    uint64_t h = Hash64(reinterpret_cast<const char*>(&flow), FlowTuple::SerializedSize);
+    uint32_t h1 = (uint32_t)h;
+    uint32_t h2 = (uint32_t)(h >> 32) | 1;
+    // (x >> 1) * width / 2^31 < width; 32-bit lanes and int<->double
+    // conversions vectorize, a 32x32->64 multiply-shift does not
+    double scale = width / 2147483648.0;
+    for (int i = 0; i < depth; i++) {
+        uint32_t x = Mix32(h1 + i * h2);
+        idx[i] = (int32_t)((int32_t)(x >> 1) * scale);
+        sign[i] = 1 - 2 * (int32_t)(x & 1);
+    }
+}
+
+
+/// ARE/AAE over all flows of the window, plus heavy hitter detection
+template <class Sketch>
+static void PrintAccuracy(std::ostream &out, const FlowSizeTruth &truth, const Sketch &sketch) {
+    double sumRelErr = 0, sumAbsErr = 0, heavySumRelErr = 0;
+    int64_t flowCnt = 0, heavyCnt = 0, truePos = 0, falsePos = 0;
+    for (const auto &[flow, size] : truth.FlowSizes()) {
+        uint32_t est = sketch.Query(flow);
+        double absErr = std::abs((double)est - size);
+        flowCnt++;
+        sumAbsErr += absErr;
+        sumRelErr += absErr / size;
+        bool isHeavy = size >= FlowSizeTruth::HeavyHitterThreshold;
+        bool reportedHeavy = est >= FlowSizeTruth::HeavyHitterThreshold;
+        if (isHeavy) {
+            heavyCnt++;
+            heavySumRelErr += absErr / size;
+        }
+        if (reportedHeavy) {
+            (isHeavy ? truePos : falsePos)++;
+        }
+    }
+    out << "flows=" << flowCnt
+        << ", ARE=" << (flowCnt ? sumRelErr / flowCnt : 0)
+        << ", AAE=" << (flowCnt ? sumAbsErr / flowCnt : 0)
+        << std::endl;
+    out << "heavy(>=" << FlowSizeTruth::HeavyHitterThreshold << "pkts)=" << heavyCnt
+        << ", ARE=" << (heavyCnt ? heavySumRelErr / heavyCnt : 0)
+        << ", precision=" << (truePos + falsePos ? (double)truePos / (truePos + falsePos) : 1)
+        << ", recall=" << (heavyCnt ? (double)truePos / heavyCnt : 1)
+        << std::endl;
+    out << std::endl << std::endl;
+}
+
+
+CountMinSketch::CountMinSketch(size_t memBytes, int depth, const FlowSizeTruth &truth)
+    : m_memBytes{memBytes},
+    m_depth{std::clamp(depth, 1, SketchHashes::MaxDepth)},
+    m_width{(uint32_t)std::max<size_t>(1, memBytes / sizeof(uint32_t) / m_depth)},
+    m_counters{new uint32_t[(size_t)m_depth * m_width]()},
+    m_truth{truth}
+{}
+
+void CountMinSketch::DoRecord(const TcpPktMetadata &pktMeta) {
+    if (pktMeta.timestamp < m_statsBeginTs) {
+        return;
+    }
+    SketchHashes hashs{pktMeta.flow, m_width, m_depth};
+    uint32_t *rows[SketchHashes::MaxDepth];
+    for (int i = 0; i < m_depth; i++) {
+        rows[i] = &m_counters[(size_t)i * m_width + hashs.idx[i]];
+        __builtin_prefetch(rows[i], 1);
+    }
+    for (int i = 0; i < m_depth; i++) {
+        *rows[i] += 1;
+    }
+}
+
+uint32_t CountMinSketch::Query(const FlowTuple &flow) const {
+    SketchHashes hashs{flow, m_width, m_depth};
+    uint32_t est = UINT32_MAX;
+    for (int i = 0; i < m_depth; i++) {
+        est = std::min(est, m_counters[(size_t)i * m_width + hashs.idx[i]]);
+    }
+    return est;
+}
+
+void CountMinSketch::PrintStats(std::ostream &out) const {
+    out << "======== CountMin mem=" << m_memBytes
+        << "B, depth=" << m_depth
+        << ", width=" << m_width
+        << " ========" << std::endl;
+    PrintAccuracy(out, m_truth, *this);
+}
+
+std::string CountMinSketch::ConfigKey(size_t memBytes, int depth) {
+    std::ostringstream oss;
+    oss << "CountMinSketch memBytes=" << memBytes << " depth=" << depth;
+    return oss.str();
+}
+
+
+CountSketch::CountSketch(size_t memBytes, int depth, const FlowSizeTruth &truth)
+    : m_memBytes{memBytes},
+    m_depth{std::clamp(depth, 1, SketchHashes::MaxDepth)},
+    m_width{(uint32_t)std::max<size_t>(1, memBytes / sizeof(int32_t) / m_depth)},
+    m_counters{new int32_t[(size_t)m_depth * m_width]()},
+    m_truth{truth}
+{}
+
+void CountSketch::DoRecord(const TcpPktMetadata &pktMeta) {
+    if (pktMeta.timestamp < m_statsBeginTs) {
+        return;
+    }
+    SketchHashes hashs{pktMeta.flow, m_width, m_depth};
+    int32_t *rows[SketchHashes::MaxDepth];
+    for (int i = 0; i < m_depth; i++) {
+        rows[i] = &m_counters[(size_t)i * m_width + hashs.idx[i]];
+        __builtin_prefetch(rows[i], 1);
+    }
+    for (int i = 0; i < m_depth; i++) {
+        *rows[i] += hashs.sign[i];
+    }
+}
+
+uint32_t CountSketch::Query(const FlowTuple &flow) const {
+    SketchHashes hashs{flow, m_width, m_depth};
+    int32_t ests[SketchHashes::MaxDepth];
+    for (int i = 0; i < m_depth; i++) {
+        int32_t c = m_counters[(size_t)i * m_width + hashs.idx[i]];
+        ests[i] = hashs.sign[i] * c;
+    }
+    std::nth_element(ests, ests + m_depth / 2, ests + m_depth);
+    int32_t median = ests[m_depth / 2];
+    if (m_depth % 2 == 0) {
+        // even depth: average the two middle estimates
+        int32_t lower = *std::max_element(ests, ests + m_depth / 2);
+        median = (median + lower) / 2;
+    }
+    return std::max(median, 0);
+}
+
+void CountSketch::PrintStats(std::ostream &out) const {
+    out << "======== CountSketch mem=" << m_memBytes
+        << "B, depth=" << m_depth
+        << ", width=" << m_width
+        << " ========" << std::endl;
+    PrintAccuracy(out, m_truth, *this);
+}
+
+std::string CountSketch::ConfigKey(size_t memBytes, int depth) {
+    std::ostringstream oss;
+    oss << "CountSketch memBytes=" << memBytes << " depth=" << depth;
+    return oss.str();
+}
+
+
+ElasticSketch::ElasticSketch(size_t memBytes, double heavyFraction, const FlowSizeTruth &truth)
+    : m_memBytes{memBytes},
+    m_heavyFraction{heavyFraction},
+    m_bucketCnt{(uint32_t)std::max<size_t>(1, memBytes * heavyFraction / Bucket::DataPlaneBytes)},
+    m_lightWidth{(uint32_t)std::max<size_t>(1, memBytes - m_bucketCnt * Bucket::DataPlaneBytes)},
+    m_heavy{new Bucket[m_bucketCnt]},
+    m_light{new uint8_t[m_lightWidth]()},
+    m_truth{truth}
+{}
+
+void ElasticSketch::AddLight(const FlowTuple &flow, uint32_t cnt) {
+    SketchHashes hashs{flow, m_lightWidth, 1};
+    uint8_t &c = m_light[hashs.idx[0]];
+    c = std::min<uint32_t>(c + cnt, UINT8_MAX);
+}
+
+uint32_t ElasticSketch::QueryLight(const FlowTuple &flow) const {
+    SketchHashes hashs{flow, m_lightWidth, 1};
+    return m_light[hashs.idx[0]];
+}
+
+void ElasticSketch::DoRecord(const TcpPktMetadata &pktMeta) {
+    if (pktMeta.timestamp < m_statsBeginTs) {
+        return;
+    }
+    const FlowTuple &flow = pktMeta.flow;
+    Bucket &bucket = m_heavy[flow.GetHashValue() % m_bucketCnt];
+    if (!bucket.IsValid()) {
+        bucket.flow = flow;
+        bucket.votePos = 1;
+        bucket.voteNeg = 0;
+        bucket.flag = false;
+    } else if (bucket.flow == flow) {
+        bucket.votePos++;
+    } else if (++bucket.voteNeg >= Lambda * bucket.votePos) {
+        // the resident flow lost the vote: move it to the light part
+        AddLight(bucket.flow, bucket.votePos);
+        bucket.flow = flow;
+        bucket.votePos = 1;
+        bucket.voteNeg = 1;
+        bucket.flag = true;
+        m_evictCnt++;
+    } else {
+        AddLight(flow, 1);
+    }
+}
+
+uint32_t ElasticSketch::Query(const FlowTuple &flow) const {
+    const Bucket &bucket = m_heavy[flow.GetHashValue() % m_bucketCnt];
+    if (bucket.IsValid() && bucket.flow == flow) {
+        return bucket.votePos + (bucket.flag ? QueryLight(flow) : 0);
+    }
+    return QueryLight(flow);
+}
+
+void ElasticSketch::PrintStats(std::ostream &out) const {
+    out << "======== Elastic mem=" << m_memBytes
+        << "B, heavyFraction=" << m_heavyFraction
+        << ", buckets=" << m_bucketCnt
+        << ", lightCounters=" << m_lightWidth
+        << " ========" << std::endl;
+    out << "evictions=" << m_evictCnt << std::endl;
+    PrintAccuracy(out, m_truth, *this);
+}
+
+std::string ElasticSketch::ConfigKey(size_t memBytes, double heavyFraction) {
+    std::ostringstream oss;
+    oss << "ElasticSketch memBytes=" << memBytes
+        << " heavyFraction=" << std::hexfloat << heavyFraction;
+    return oss.str();
+}
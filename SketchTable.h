@@ -0,0 +1,144 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include "FlowTuple.h"
+#include "TimeHelper.h"
+
+struct TcpPktMetadata;
+
+/// @brief Exact per-flow packet counts of the stats window, the ground truth
+/// sketches are compared against.
+class FlowSizeTruth {
+public:
+    /// flows at least this large (in packets) count as heavy hitters
+    static constexpr uint32_t HeavyHitterThreshold = 1000;
+
+    void DoRecord(const TcpPktMetadata &pktMeta);
+    void SetStatsBeginTs(nanoseconds ts) { m_statsBeginTs = ts; }
+
+    struct FlowHash {
+        size_t operator() (const FlowTuple &flow) const { return flow.GetHashValue(); }
+    };
+    const std::unordered_map<FlowTuple, uint32_t, FlowHash>& FlowSizes() const { return m_flowSizes; }
+
+private:
+    nanoseconds m_statsBeginTs{0};
+    std::unordered_map<FlowTuple, uint32_t, FlowHash> m_flowSizes;
+};
+
+
+/// @brief Per-row counter indices of a flow in a d x w counter array.
+/// All rows derive from one 64-bit hash: row i mixes h1 + i*h2 with
+/// murmur3's 32-bit finalizer and maps it into [0, w) by a multiply-shift
+/// done in double precision. Every step has a packed form, so at -O3 the
+/// row loop vectorizes (4 rows per SSE2 vector, 8 per AVX2 vector) and one
+/// flow costs a single hash call plus a vector op or two whatever d is.
+/// Sketches then prefetch every row's counter before touching any; the
+/// counter updates themselves are scattered and stay scalar.
+struct SketchHashes {
+    static constexpr int MaxDepth = 8;
+
+    uint32_t idx[MaxDepth];
+    int32_t sign[MaxDepth]; // +1/-1 for Count-Sketch, from a bit the index barely depends on
+
+    /// fills the first `depth` rows only
+    SketchHashes(const FlowTuple &flow, uint32_t width, int depth);
+};
+
+
+/// Memory a table cell (key + 4 counters) takes in the data plane, so that
+/// sketches are sized against the exact tables by the same byte budget.
+constexpr size_t ExactCellBytes = FlowTuple::SerializedSize + 16;
+
+
+class CountMinSketch {
+public:
+    CountMinSketch(size_t memBytes, int depth, const FlowSizeTruth &truth);
+
+    void DoRecord(const TcpPktMetadata &pktMeta);
+    void SetStatsBeginTs(nanoseconds ts) { m_statsBeginTs = ts; }
+    void PrintStats(std::ostream &out = std::cout) const;
+
+    uint32_t Query(const FlowTuple &flow) const;
+
+    static std::string ConfigKey(size_t memBytes, int depth);
+
+private:
+    size_t m_memBytes;
+    int m_depth;
+    uint32_t m_width;
+    std::unique_ptr<uint32_t[]> m_counters; // depth rows of width counters
+    const FlowSizeTruth &m_truth;
+    nanoseconds m_statsBeginTs{0};
+};
+
+
+class CountSketch {
+public:
+    CountSketch(size_t memBytes, int depth, const FlowSizeTruth &truth);
+
+    void DoRecord(const TcpPktMetadata &pktMeta);
+    void SetStatsBeginTs(nanoseconds ts) { m_statsBeginTs = ts; }
+    void PrintStats(std::ostream &out = std::cout) const;
+
+    uint32_t Query(const FlowTuple &flow) const;
+
+    static std::string ConfigKey(size_t memBytes, int depth);
+
+private:
+    size_t m_memBytes;
+    int m_depth;
+    uint32_t m_width;
+    std::unique_ptr<int32_t[]> m_counters;
+    const FlowSizeTruth &m_truth;
+    nanoseconds m_statsBeginTs{0};
+};
+
+
+/// @brief Elastic sketch: a heavy part of voting buckets holding large flows
+/// exactly, backed by a light part of 8-bit Count-Min counters.
+/// The light part is a single row (it ignores SketchDepth), so its whole
+/// byte budget goes to width; it only holds small flows and the spill of
+/// flows evicted from the heavy part.
+class ElasticSketch {
+public:
+    static constexpr int Lambda = 8; // evict when negative votes reach Lambda x positive votes
+
+    /// @param heavyFraction share of `memBytes` spent on heavy buckets
+    ElasticSketch(size_t memBytes, double heavyFraction, const FlowSizeTruth &truth);
+
+    void DoRecord(const TcpPktMetadata &pktMeta);
+    void SetStatsBeginTs(nanoseconds ts) { m_statsBeginTs = ts; }
+    void PrintStats(std::ostream &out = std::cout) const;
+
+    uint32_t Query(const FlowTuple &flow) const;
+
+    static std::string ConfigKey(size_t memBytes, double heavyFraction);
+
+private:
+    struct Bucket {
+        FlowTuple flow;
+        uint32_t votePos = 0;
+        uint32_t voteNeg = 0;
+        bool flag = false; // the flow may also have packets in the light part
+
+        static constexpr size_t DataPlaneBytes = FlowTuple::SerializedSize + 9;
+
+        Bucket() { flow.proto = 0; }
+        bool IsValid() const { return flow.proto != 0; }
+    };
+
+    size_t m_memBytes;
+    double m_heavyFraction;
+    uint32_t m_bucketCnt;
+    uint32_t m_lightWidth;
+    std::unique_ptr<Bucket[]> m_heavy;
+    std::unique_ptr<uint8_t[]> m_light;
+    const FlowSizeTruth &m_truth;
+    nanoseconds m_statsBeginTs{0};
+    int64_t m_evictCnt = 0;
+
+    void AddLight(const FlowTuple &flow, uint32_t cnt);
+    uint32_t QueryLight(const FlowTuple &flow) const;
+};
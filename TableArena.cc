@@ -0,0 +1,95 @@
+#include "TableArena.h"
+
+#include <iostream>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static constexpr int MpolPreferred = 1; // from <numaif.h>, avoids a libnuma dependency
+
+TableArena::TableArena(size_t bytes, const Options &options)
+    : m_pageMode{options.pageMode}
+{
+    if (bytes == 0) {
+        bytes = 1;
+    }
+    constexpr int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    if (m_pageMode == PageMode::ExplicitHuge) {
+        m_mappedBytes = AlignUp(bytes, HugePageSize);
+        m_data = mmap(nullptr, m_mappedBytes, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+        if (m_data == MAP_FAILED) {
+            static bool warned = false;
+            if (!warned) {
+                std::cerr << "MAP_HUGETLB failed (no reserved huge pages?),"
+                          << " falling back to transparent huge pages\n";
+                warned = true;
+            }
+            m_data = nullptr;
+            m_pageMode = PageMode::TransparentHuge;
+        }
+    }
+
+    if (m_pageMode == PageMode::TransparentHuge) {
+        // over-map by one huge page, then trim so the region is 2MB aligned
+        m_mappedBytes = AlignUp(bytes, HugePageSize);
+        size_t rawBytes = m_mappedBytes + HugePageSize;
+        void *raw = mmap(nullptr, rawBytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc{};
+        }
+        auto rawAddr = reinterpret_cast<uintptr_t>(raw);
+        auto alignedAddr = AlignUp(rawAddr, HugePageSize);
+        if (alignedAddr > rawAddr) {
+            munmap(raw, alignedAddr - rawAddr);
+        }
+        size_t tail = rawAddr + rawBytes - (alignedAddr + m_mappedBytes);
+        if (tail > 0) {
+            munmap(reinterpret_cast<void*>(alignedAddr + m_mappedBytes), tail);
+        }
+        m_data = reinterpret_cast<void*>(alignedAddr);
+        madvise(m_data, m_mappedBytes, MADV_HUGEPAGE);
+    } else if (m_pageMode == PageMode::Default) {
+        m_mappedBytes = AlignUp(bytes, sysconf(_SC_PAGESIZE));
+        m_data = mmap(nullptr, m_mappedBytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (m_data == MAP_FAILED) {
+            throw std::bad_alloc{};
+        }
+    }
+
+    if (options.numaNode >= 0 && options.numaNode < (int)sizeof(unsigned long) * 8) {
+        // must happen before the first touch to take effect
+        unsigned long nodeMask = 1UL << options.numaNode;
+        syscall(SYS_mbind, m_data, m_mappedBytes, MpolPreferred,
+                &nodeMask, sizeof(nodeMask) * 8, 0);
+    }
+}
+
+TableArena::~TableArena() {
+    if (m_data != nullptr) {
+        munmap(m_data, m_mappedBytes);
+    }
+}
+
+size_t TableArena::ResidentBytes() const {
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> residency(m_mappedBytes / pageSize);
+    if (mincore(m_data, m_mappedBytes, residency.data()) != 0) {
+        return 0;
+    }
+    size_t residentPages = 0;
+    for (auto x : residency) {
+        residentPages += (x & 1);
+    }
+    return residentPages * pageSize;
+}
+
+const char* ToString(TableArena::PageMode mode) {
+    switch (mode) {
+    case TableArena::PageMode::Default: return "4KB";
+    case TableArena::PageMode::TransparentHuge: return "THP";
+    case TableArena::PageMode::ExplicitHuge: return "hugetlb";
+    }
+    return "?";
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+/// @brief Page-granular backing memory for flow tables.
+/// Allocated with mmap, preferably on 2MB huge pages, so that random
+/// accesses over tens of MB don't thrash the TLB.
+class TableArena {
+public:
+    static constexpr size_t CacheLineSize = 64;
+    static constexpr size_t HugePageSize = 2 << 20;
+
+    enum class PageMode {
+        Default,         // 4KB pages
+        TransparentHuge, // 2MB aligned + madvise(MADV_HUGEPAGE)
+        ExplicitHuge,    // MAP_HUGETLB, falls back to TransparentHuge
+    };
+
+    struct Options {
+        PageMode pageMode = PageMode::TransparentHuge;
+        int numaNode = -1; // if negative, pages land where they are first touched
+    };
+
+    /// options used by tables that don't pass their own
+    static Options& DefaultOptions() {
+        static Options options;
+        return options;
+    }
+
+    explicit TableArena(size_t bytes, const Options &options = DefaultOptions());
+    ~TableArena();
+    TableArena(const TableArena&) = delete;
+    TableArena& operator= (const TableArena&) = delete;
+
+    void* Data() const { return m_data; }
+    size_t Size() const { return m_mappedBytes; }
+    PageMode GetPageMode() const { return m_pageMode; }
+
+    /// bytes currently backed by physical memory (via mincore)
+    size_t ResidentBytes() const;
+
+    static constexpr size_t AlignUp(size_t n, size_t align) {
+        return (n + align - 1) / align * align;
+    }
+
+private:
+    void *m_data = nullptr;
+    size_t m_mappedBytes = 0;
+    PageMode m_pageMode;
+};
+
+const char* ToString(TableArena::PageMode mode);
+
+
+/// @brief Fixed-size array of T living in a TableArena, as groups of
+/// `groupSize` elements (e.g. the cells of a table row). Elements are packed
+/// within a group and each group is padded so that it doesn't straddle more
+/// cache lines than it has to (e.g. a row of 4 36B cells every 192B, a
+/// single 36B record every 64B).
+template <class T>
+class ArenaArray {
+public:
+    static constexpr size_t GroupStride(size_t groupSize) {
+        size_t bytes = groupSize * sizeof(T);
+        if (bytes >= TableArena::CacheLineSize) {
+            return TableArena::AlignUp(bytes, TableArena::CacheLineSize);
+        }
+        size_t stride = 1;
+        while (stride < bytes) {
+            stride <<= 1;
+        }
+        return stride < alignof(T) ? alignof(T) : stride;
+    }
+    /// memory of `groupCnt` groups, e.g. for table budgeting
+    static constexpr size_t BytesFor(size_t groupCnt, size_t groupSize = 1) {
+        return groupCnt * GroupStride(groupSize);
+    }
+
+    /// tag to leave groups unconstructed until Construct(group), so that a
+    /// large array can be set up without touching all of its pages at once
+    struct Deferred {};
+
+    explicit ArenaArray(size_t groupCnt, size_t groupSize = 1,
+                        const TableArena::Options &options = TableArena::DefaultOptions())
+        : ArenaArray(groupCnt, groupSize, Deferred{}, options)
+    {
+        for (size_t group = 0; group < groupCnt; group++) {
+            Construct(group);
+        }
+    }
+
+    ArenaArray(size_t groupCnt, size_t groupSize, Deferred,
+               const TableArena::Options &options = TableArena::DefaultOptions())
+        : m_groupCnt{groupCnt},
+        m_groupSize{groupSize},
+        m_groupStride{GroupStride(groupSize)},
+        m_arena{BytesFor(groupCnt, groupSize), options},
+        m_base{static_cast<char*>(m_arena.Data())}
+    {
+        static_assert(std::is_trivially_destructible<T>::value);
+        static_assert(std::is_trivially_copyable<T>::value);
+    }
+
+    /// constructs every element of `group`
+    void Construct(size_t group) {
+        for (size_t i = 0; i < m_groupSize; i++) {
+            new (m_base + group * m_groupStride + i * sizeof(T)) T{};
+        }
+    }
+
+    T& At(size_t group, size_t i) {
+        return *std::launder(reinterpret_cast<T*>(m_base + group * m_groupStride + i * sizeof(T)));
+    }
+    const T& At(size_t group, size_t i) const {
+        return *std::launder(reinterpret_cast<const T*>(m_base + group * m_groupStride + i * sizeof(T)));
+    }
+    /// first element of `group`, i.e. the element itself when groupSize is 1
+    T& operator[] (size_t group) { return At(group, 0); }
+    const T& operator[] (size_t group) const { return At(group, 0); }
+
+    size_t GroupCnt() const { return m_groupCnt; }
+    size_t GroupSize() const { return m_groupSize; }
+    const TableArena& Arena() const { return m_arena; }
+
+    /// all groups as one block of ByteSize() bytes, e.g. for snapshots
+    void* Bytes() { return m_base; }
+    const void* Bytes() const { return m_base; }
+    size_t ByteSize() const { return m_groupCnt * m_groupStride; }
+
+private:
+    size_t m_groupCnt;
+    size_t m_groupSize;
+    size_t m_groupStride;
+    TableArena m_arena;
+    char *m_base;
+};
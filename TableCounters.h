@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Stats-window counters of one table, summable across tables
+/// (e.g. the same config replayed at several switch ports).
+struct TableCounters {
+    int64_t records = 0;
+    int64_t expirs = 0;
+    int64_t evicts = 0;    // collisions (FlowTable) or cast-outs (MultiLevelTable)
+    int64_t occupancy = 0; // valid cells at the end of the replay
+    size_t memBytes = 0;   // table memory (cells)
+
+    TableCounters& operator+= (const TableCounters &other) {
+        records += other.records;
+        expirs += other.expirs;
+        evicts += other.evicts;
+        occupancy += other.occupancy;
+        memBytes += other.memBytes;
+        return *this;
+    }
+};
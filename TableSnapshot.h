@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "TimeHelper.h"
+
+/// @brief In-memory image of a table's full state (cells, counters, RNG,
+/// stats flags, epoch series) plus where in the trace it was taken, so that
+/// variants of a table can fork from one shared prefix replay.
+/// Cell arrays go in with one memcpy each; each table defines its own
+/// layout and only restores images of a table with the same geometry.
+class TableSnapshot {
+public:
+    /// packets before this have been replayed; replays resume here, which
+    /// GenPktTrace traces seek to through their TraceIndex
+    nanoseconds traceTs{0};
+
+    void PutBytes(const void *data, size_t size) {
+        const char *bytes = static_cast<const char*>(data);
+        m_data.insert(m_data.end(), bytes, bytes + size);
+    }
+    template <class T>
+    void Put(const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value);
+        PutBytes(&value, sizeof(T));
+    }
+
+    size_t Size() const { return m_data.size(); }
+
+    /// reads back what was Put, in the same order
+    class Reader {
+    public:
+        explicit Reader(const TableSnapshot &snapshot) : m_snapshot{snapshot} {}
+
+        bool GetBytes(void *data, size_t size) {
+            if (m_pos + size > m_snapshot.m_data.size()) {
+                return false;
+            }
+            std::memcpy(data, m_snapshot.m_data.data() + m_pos, size);
+            m_pos += size;
+            return true;
+        }
+        template <class T>
+        bool Get(T &value) {
+            static_assert(std::is_trivially_copyable<T>::value);
+            return GetBytes(&value, sizeof(T));
+        }
+
+    private:
+        const TableSnapshot &m_snapshot;
+        size_t m_pos = 0;
+    };
+
+private:
+    std::vector<char> m_data;
+};
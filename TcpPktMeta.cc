@@ -59,9 +59,16 @@ void ReadUInt(std::istream &in, UIntType *pvalue) {
 
 using MagicNumberType = uint16_t;
 static constexpr MagicNumberType MagicNumber = 0x7777;
+static constexpr MagicNumberType PortMagicNumber = 0x7778; // followed by a uint16 port ID
 
 void TcpPktMetadata::WriteToFstream(std::ostream &out) {
-    WriteUInt(out, MagicNumber);
+    // port 0 keeps the original record layout, so single-port traces don't change
+    if (portId == 0) {
+        WriteUInt(out, MagicNumber);
+    } else {
+        WriteUInt(out, PortMagicNumber);
+        WriteUInt(out, portId);
+    }
     WriteUInt(out, (uint64_t)timestamp.count());
     WriteUInt(out, phyPktSize);
     WriteUInt(out, flow.srcAddr);
@@ -80,7 +87,9 @@ TcpPktMetadata::FromFstream(std::istream &in) {
 
     MagicNumberType magic = 0;
     ReadUInt(in, &magic);
-    if (magic != MagicNumber) {
+    if (magic == PortMagicNumber) {
+        ReadUInt(in, &pktMeta.portId);
+    } else if (magic != MagicNumber) {
         return {};
     }
 
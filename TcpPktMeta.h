@@ -13,6 +13,8 @@ struct TcpPktMetadata {
     uint8_t tcpFlags;
     uint32_t payloadSize;
 
+    uint16_t portId = 0; // switch egress port the packet was captured at
+
 
     static std::optional<TcpPktMetadata> FromPppPkt(Ptr<const Packet> pkt, ns3::Time timestamp);
 
@@ -0,0 +1,99 @@
+#include "TraceIndex.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "TcpPktMeta.h"
+
+namespace fs = std::filesystem;
+
+static constexpr uint64_t IndexMagic = 0x3158444e49544b50ULL; // "PKTINDX1"
+
+struct IndexHeader {
+    uint64_t magic;
+    uint64_t traceSize;
+    int64_t traceMtime;
+    uint32_t stride;
+    uint32_t reserved;
+    uint64_t entryCnt;
+};
+
+uint64_t TraceIndex::OffsetBefore(nanoseconds ts) const {
+    // the last entry strictly before ts: records at exactly ts may sit just
+    // before an entry stamped ts
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), ts.count(),
+        [](const Entry &entry, int64_t t) { return entry.tsNs < t; });
+    if (it == m_entries.begin()) {
+        return 0;
+    }
+    return std::prev(it)->offset;
+}
+
+bool TraceIndex::Save(const std::string &traceFilename) const {
+    std::error_code ec;
+    IndexHeader hdr{};
+    hdr.magic = IndexMagic;
+    hdr.traceSize = fs::file_size(traceFilename, ec);
+    hdr.traceMtime = fs::last_write_time(traceFilename, ec).time_since_epoch().count();
+    hdr.stride = Stride;
+    hdr.entryCnt = m_entries.size();
+    if (ec) {
+        return false;
+    }
+
+    // write then rename, so that a concurrent reader never sees half an index
+    std::string filename = IndexFilename(traceFilename);
+    std::string tmpFilename = filename + ".tmp";
+    std::ofstream out{tmpFilename, std::ios::binary};
+    if (!out.is_open()) {
+        std::cout << "Failed to open " << tmpFilename << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    out.write(reinterpret_cast<const char*>(m_entries.data()), m_entries.size() * sizeof(Entry));
+    out.close();
+    fs::rename(tmpFilename, filename, ec);
+    return !ec && out;
+}
+
+bool TraceIndex::Load(const std::string &traceFilename) {
+    std::ifstream in{IndexFilename(traceFilename), std::ios::binary};
+    IndexHeader hdr{};
+    if (!in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)) || hdr.magic != IndexMagic) {
+        return false;
+    }
+    std::error_code ec;
+    uint64_t traceSize = fs::file_size(traceFilename, ec);
+    int64_t traceMtime = fs::last_write_time(traceFilename, ec).time_since_epoch().count();
+    if (ec || hdr.traceSize != traceSize || hdr.traceMtime != traceMtime || hdr.stride != Stride) {
+        return false; // the trace was regenerated
+    }
+    m_entries.resize(hdr.entryCnt);
+    return (bool)in.read(reinterpret_cast<char*>(m_entries.data()), hdr.entryCnt * sizeof(Entry));
+}
+
+TraceIndex TraceIndex::LoadOrBuild(const std::string &traceFilename) {
+    TraceIndex index;
+    if (index.Load(traceFilename)) {
+        return index;
+    }
+
+    index = TraceIndex{};
+    std::ifstream in{traceFilename, std::ios::binary};
+    while (1) {
+        bool isDue = index.IsDue();
+        uint64_t offset = isDue ? (uint64_t)in.tellg() : 0;
+        std::optional pktMeta = TcpPktMetadata::FromFstream(in);
+        if (!pktMeta.has_value()) {
+            break;
+        }
+        if (isDue) {
+            index.Add(pktMeta->timestamp, offset);
+        }
+    }
+    if (!index.Save(traceFilename)) {
+        std::cout << "Failed to save " << IndexFilename(traceFilename) << std::endl;
+    }
+    return index;
+}
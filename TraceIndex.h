@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TimeHelper.h"
+
+/// @brief Sparse timestamp -> file offset index of a GenPktTrace .bin trace,
+/// stored next to it as `<trace>.idx`, so that a replay can start near a
+/// given time instead of at the first byte.
+/// One entry every `Stride` records; records are in timestamp order.
+class TraceIndex {
+public:
+    static constexpr uint32_t Stride = 4096;
+
+    struct Entry {
+        int64_t tsNs;
+        uint64_t offset;
+    };
+
+    /// call for every record before writing it; true if this one gets an entry
+    bool IsDue() {
+        return m_recordCnt++ % Stride == 0;
+    }
+    void Add(nanoseconds ts, uint64_t offset) {
+        m_entries.push_back({ts.count(), offset});
+    }
+
+    /// offset of the last indexed record before `ts` (0 if none), so that
+    /// every record at `ts` or later lies after it
+    uint64_t OffsetBefore(nanoseconds ts) const;
+
+    /// call after the trace is closed; the index remembers its size and mtime
+    bool Save(const std::string &traceFilename) const;
+    /// @brief Load the index of `traceFilename`, rebuilding it with one scan
+    /// of the trace if it is missing or older than the trace.
+    static TraceIndex LoadOrBuild(const std::string &traceFilename);
+
+    static std::string IndexFilename(const std::string &traceFilename) {
+        return traceFilename + ".idx";
+    }
+
+private:
+    uint64_t m_recordCnt = 0;
+    std::vector<Entry> m_entries;
+
+    bool Load(const std::string &traceFilename);
+};
@@ -0,0 +1,115 @@
+#include "TraceStats.h"
+
+#include <fstream>
+#include <sstream>
+#include "ns3/tcp-header.h"
+#include "TcpPktMeta.h"
+
+
+TraceStats::TraceStats(nanoseconds epochDuration)
+    : m_epochDuration{epochDuration}
+{}
+
+void TraceStats::CloseFlow(const FlowState &state) {
+    m_flowBytes.Add(state.bytes);
+    m_flowDuration.Add(state.lastTs - state.firstTs);
+}
+
+void TraceStats::Record(const TcpPktMetadata &pktMeta) {
+    int64_t now = pktMeta.timestamp.count();
+    m_pktSize.Add(pktMeta.phyPktSize);
+    if (m_prevTs >= 0) {
+        m_interArrival.Add(now - m_prevTs);
+    }
+    m_prevTs = now;
+
+    int64_t epoch = now / m_epochDuration.count();
+    if (epoch != m_epoch) {
+        if (m_epoch >= 0) {
+            m_concurrentFlows.Add(m_epochFlowCnt);
+        }
+        m_epoch = epoch;
+        m_epochFlowCnt = 0;
+    }
+
+    auto [it, isNew] = m_openFlows.try_emplace(pktMeta.flow, FlowState{now, now, 0, -1});
+    FlowState &state = it->second;
+    state.lastTs = now;
+    state.bytes += pktMeta.phyPktSize;
+    if (state.epoch != epoch) {
+        state.epoch = epoch;
+        m_epochFlowCnt++;
+    }
+
+    constexpr uint8_t CloseMask = TcpHeader::FIN | TcpHeader::RST;
+    if (pktMeta.tcpFlags & CloseMask) {
+        CloseFlow(state);
+        m_openFlows.erase(it);
+    }
+}
+
+void TraceStats::Finish() {
+    for (const auto &[flow, state] : m_openFlows) {
+        CloseFlow(state);
+    }
+    m_openFlows.clear();
+    if (m_epoch >= 0) {
+        m_concurrentFlows.Add(m_epochFlowCnt);
+        m_epoch = -1;
+    }
+}
+
+void TraceStats::Merge(const TraceStats &other) {
+    m_pktSize.Merge(other.m_pktSize);
+    m_interArrival.Merge(other.m_interArrival);
+    m_flowBytes.Merge(other.m_flowBytes);
+    m_flowDuration.Merge(other.m_flowDuration);
+    m_concurrentFlows.Merge(other.m_concurrentFlows);
+}
+
+void TraceStats::Print(std::ostream &out) const {
+    out << "======== Trace Distributions ========\n";
+    auto print = [&out](const char *name, const DDSketch &sketch) {
+        out << name << ": ";
+        sketch.PrintSummary(out);
+        out << "\n";
+    };
+    print("pktSize(B)", m_pktSize);
+    print("interArrival(ns)", m_interArrival);
+    print("flowBytes(B)", m_flowBytes);
+    print("flowDuration(ns)", m_flowDuration);
+    std::ostringstream concurrentName;
+    concurrentName << "concurrentFlows/epoch(" << std::chrono::duration_cast<microseconds>(m_epochDuration) << ")";
+    print(concurrentName.str().c_str(), m_concurrentFlows);
+}
+
+bool TraceStats::Save(const std::string &filename) const {
+    std::ofstream out{filename};
+    if (!out.is_open()) {
+        std::cout << "Failed to open " << filename << std::endl;
+        return false;
+    }
+    out << m_epochDuration.count() << '\n';
+    for (const DDSketch *sketch : {&m_pktSize, &m_interArrival, &m_flowBytes, &m_flowDuration, &m_concurrentFlows}) {
+        sketch->Write(out);
+    }
+    return (bool)out;
+}
+
+std::optional<TraceStats> TraceStats::Load(const std::string &filename) {
+    std::ifstream in{filename};
+    int64_t epochNs;
+    if (!(in >> epochNs)) {
+        return {};
+    }
+    TraceStats stats{nanoseconds{epochNs}};
+    for (DDSketch *sketch : {&stats.m_pktSize, &stats.m_interArrival, &stats.m_flowBytes,
+                             &stats.m_flowDuration, &stats.m_concurrentFlows}) {
+        std::optional<DDSketch> loaded = DDSketch::Read(in);
+        if (!loaded.has_value()) {
+            return {};
+        }
+        *sketch = std::move(loaded.value());
+    }
+    return stats;
+}
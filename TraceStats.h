@@ -0,0 +1,61 @@
+#pragma once
+
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "FlowTuple.h"
+#include "QuantileSketch.h"
+#include "TimeHelper.h"
+
+struct TcpPktMetadata;
+
+/// @brief Streaming distributions of a packet trace, in fixed memory apart
+/// from one small entry per open flow: packet size, inter-arrival time,
+/// per-flow bytes and duration, and concurrent flows per epoch.
+/// Fed from GenPktTrace's tx callback or from a replay; results of sharded
+/// runs merge through Save / Load / Merge.
+class TraceStats {
+public:
+    explicit TraceStats(nanoseconds epochDuration = 10ms);
+
+    void Record(const TcpPktMetadata &pktMeta);
+    /// count flows still open and the last epoch; call once after the last packet
+    void Finish();
+
+    void Merge(const TraceStats &other);
+    void Print(std::ostream &out) const;
+
+    bool Save(const std::string &filename) const;
+    static std::optional<TraceStats> Load(const std::string &filename);
+
+    /// where GenPktTrace saves the stats of a trace
+    static std::string StatsFilename(const std::string &traceFilename) {
+        return traceFilename + ".stats";
+    }
+
+private:
+    struct FlowState {
+        int64_t firstTs;
+        int64_t lastTs;
+        uint64_t bytes;
+        int64_t epoch; // last epoch the flow was counted as active in
+    };
+    struct FlowHash {
+        size_t operator() (const FlowTuple &flow) const { return flow.GetHashValue(); }
+    };
+
+    nanoseconds m_epochDuration;
+    DDSketch m_pktSize;         // B on the wire
+    DDSketch m_interArrival;    // ns
+    DDSketch m_flowBytes;       // B on the wire
+    DDSketch m_flowDuration;    // ns, first to last packet
+    DDSketch m_concurrentFlows; // flows with a packet in the epoch
+
+    std::unordered_map<FlowTuple, FlowState, FlowHash> m_openFlows;
+    int64_t m_prevTs = -1;
+    int64_t m_epoch = -1;
+    uint32_t m_epochFlowCnt = 0;
+
+    void CloseFlow(const FlowState &state);
+};
@@ -9,16 +9,34 @@
 #include "ns3/node-container.h"
 #include "ns3/node.h"
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <map>
+#include <optional>
 #include <memory>
 #include <fstream>
+#include <functional>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <filesystem>
+#include <set>
+#include <thread>
 
 #include "TcpPktMeta.h"
 #include "FlowTable.h"
 #include "MultiLevelTable.h"
+#include "ConcurrentMultiLevelTable.h"
+#include "PcapReader.h"
+#include "PacedReplay.h"
+#include "ResizePolicy.h"
+#include "ResultCache.h"
+#include "TraceIndex.h"
+#include "TraceStats.h"
+#include "JobScheduler.h"
+#include "SketchTable.h"
 #include "MakeCallbackHelper.h"
 
 
@@ -34,6 +52,22 @@ string linkRate = "100Gbps";
 string linkDelay = "500ns";
 milliseconds TraffDuration = 1000ms;
 int zip = 1;
+int threadCnt = 4;
+int portCnt = 1; // egress ports (receivers) of the generated fabric
+string epochCsvFilename;
+double paceSpeedup = 1.0;
+microseconds maxQueueDelay = 10us;
+microseconds warmup = -1us; // replay starts this long before the stats window; negative: from the first packet
+string resultCacheDir{"scratch/measure-sim/result-cache"};
+string replacePolicies{"ewma"};
+microseconds forkAt = -1us; // 'whatIf' forks variants here; negative: at the stats window
+string whatIfTtls{"250,500,1000,2000"};
+ResizePolicy elasticResize; // enabled: the sweep adds one elastic table per shape
+
+const vector<int> FlowTableSizes{4'000, 20'000, 40'000, 80'000, 200'000};
+constexpr int ElasticInitSize = 20'000;
+constexpr int SketchDepth = 4;
+constexpr double ElasticHeavyFraction = 0.25;
 
 void GenPktTrace(string traffFilename, string pktTraceFilename) {
     Time::SetResolution (Time::NS);
@@ -55,10 +89,10 @@ void GenPktTrace(string traffFilename, string pktTraceFilename) {
     int senderCnt = (flowCnt + 64999) / 65000;
 
 
-    // build topo
+    // build topo: senders -> middleNode -> one receiver per egress port
     NodeContainer senderNodes{(uint32_t)senderCnt};
     auto middleNode = CreateObject<Node>();
-    auto receiverNode = CreateObject<Node>();
+    NodeContainer receiverNodes{(uint32_t)portCnt};
     NetDeviceContainer senderNetDevices;
     NetDeviceContainer senderSidePorts;
 
@@ -70,13 +104,17 @@ void GenPktTrace(string traffFilename, string pktTraceFilename) {
         senderNetDevices.Add(devs.Get(0));
         senderSidePorts.Add(devs.Get(1));
     }
-    NetDeviceContainer rightNetDevs = p2p.Install ({middleNode, receiverNode});
-    Ptr<NetDevice> receiverSidePort = rightNetDevs.Get(0);
-    Ptr<NetDevice> receiverNetDev = rightNetDevs.Get(1);
+    NetDeviceContainer receiverSidePorts;
+    NetDeviceContainer receiverNetDevs;
+    for (int port = 0; port < portCnt; port++) {
+        NetDeviceContainer devs = p2p.Install ({middleNode, receiverNodes.Get(port)});
+        receiverSidePorts.Add(devs.Get(0));
+        receiverNetDevs.Add(devs.Get(1));
+    }
     InternetStackHelper stack;
     stack.Install(senderNodes);
     stack.Install(middleNode);
-    stack.Install(receiverNode);
+    stack.Install(receiverNodes);
 
     Ipv4AddressHelper address;
     for (int i = 0; i < senderCnt; i++) {
@@ -86,15 +124,19 @@ void GenPktTrace(string traffFilename, string pktTraceFilename) {
         address.Assign(senderNetDevices.Get(i));
         address.Assign(senderSidePorts.Get(i));
     }
-    address.SetBase ("10.1.0.0", "255.255.255.0");
-    auto receiverAddr = address.Assign (receiverNetDev).GetAddress(0);
-    address.Assign(receiverSidePort);
+    vector<Ipv4Address> receiverAddrs;
+    for (int port = 0; port < portCnt; port++) {
+        // 10.1.<port>.0/24
+        address.SetBase (Ipv4Address{(10U << 24) | (1U << 16) | ((uint32_t)port << 8)}, "255.255.255.0");
+        receiverAddrs.push_back(address.Assign (receiverNetDevs.Get(port)).GetAddress(0));
+        address.Assign(receiverSidePorts.Get(port));
+    }
     Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
     uint16_t recvPort = 9;
     InetSocketAddress sinkAddr{Ipv4Address::GetAny(), recvPort};
     PacketSinkHelper sink{"ns3::TcpSocketFactory", sinkAddr};
-    ApplicationContainer sinkApps = sink.Install(receiverNode);
+    ApplicationContainer sinkApps = sink.Install(receiverNodes);
     sinkApps.Start(Seconds (0));
 
 
@@ -108,7 +150,7 @@ void GenPktTrace(string traffFilename, string pktTraceFilename) {
         ts = 1 + (ts - 1) / zip;
         genTotalBytes += flowSize;
         uint16_t dstPort = recvPort;
-        InetSocketAddress dstSockAddr = {receiverAddr, dstPort};
+        InetSocketAddress dstSockAddr = {receiverAddrs[dstMachine % portCnt], dstPort};
         BulkSendHelper source{"ns3::TcpSocketFactory", dstSockAddr};
         int sender = i % senderCnt;
         uint16_t srcPort = 13 + ((i / senderCnt) % 65000);
@@ -141,7 +183,9 @@ void GenPktTrace(string traffFilename, string pktTraceFilename) {
     int64_t caredTxByteCnt = 0;
     int64_t txPktSizeHist[16] = {0};
     Time prevTs{0};
-    auto txCb = [&](Ptr<const Packet> pkt) {
+    TraceIndex traceIndex;
+    TraceStats traceStats{EpochSeries::DefaultEpochDuration()};
+    auto txCb = [&](uint16_t port, Ptr<const Packet> pkt) {
         Time now = Now();
         totalTxPktCnt++;
         totalTxByteCnt += pkt->GetSize();
@@ -150,24 +194,43 @@ void GenPktTrace(string traffFilename, string pktTraceFilename) {
             caredTxByteCnt += pkt->GetSize();
         }
 
-        auto i = pkt->GetSize() / 100;
+        auto i = std::min<uint32_t>(pkt->GetSize() / 100, 15); // the last bucket is 1500 and up
         txPktSizeHist[i]++;
 
         std::optional pktMeta = TcpPktMetadata::FromPppPkt(pkt, now);
         if (!pktMeta.has_value()) {
             return;
         }
+        pktMeta->portId = port;
         flowStats.Record(pktMeta.value());
+        if (now >= measureStartTime) {
+            traceStats.Record(pktMeta.value());
+        }
+        if (traceIndex.IsDue()) {
+            traceIndex.Add(pktMeta->timestamp, pktTraceFile.tellp());
+        }
         pktMeta->WriteToFstream(pktTraceFile);
     };
-    auto ns3Callback = MakeCallbackFromCallable (txCb);
-    receiverSidePort->TraceConnectWithoutContext("PhyTxBegin", ns3Callback);
+    auto portTxCb = [&txCb](uint16_t port) {
+        return [&txCb, port](Ptr<const Packet> pkt) { txCb(port, pkt); };
+    };
+    // callbacks must stay put while the simulation runs
+    vector<decltype(portTxCb(0))> portTxCbs;
+    portTxCbs.reserve(portCnt);
+    for (int port = 0; port < portCnt; port++) {
+        portTxCbs.push_back(portTxCb(port));
+        auto ns3Callback = MakeCallbackFromCallable (portTxCbs.back());
+        receiverSidePorts.Get(port)->TraceConnectWithoutContext("PhyTxBegin", ns3Callback);
+    }
 
 
     Simulator::Stop(measureEndTime);
     Simulator::Run ();
 
     pktTraceFile.close();
+    if (!traceIndex.Save(pktTraceFilename)) {
+        std::cout << "Failed to save " << TraceIndex::IndexFilename(pktTraceFilename) << std::endl;
+    }
 
     std::cout << "TX Total: "
             << totalTxPktCnt << " pkts, " << totalTxByteCnt << " B" << std::endl;
@@ -177,92 +240,1084 @@ void GenPktTrace(string traffFilename, string pktTraceFilename) {
     flowStats.PrintStats();
 
     std::cout << "\n\n======== Packet Size Distribution ========\n";
-    for (int i = 0; i < 16; i++) {
+    for (int i = 0; i < 15; i++) {
         std::cout << i * 100 << "~" << (i+1)*100 << ": " << txPktSizeHist[i] << std::endl;
     }
+    std::cout << "1500~: " << txPktSizeHist[15] << std::endl;
+
+    std::cout << "\n\n";
+    traceStats.Finish();
+    traceStats.Print(std::cout);
+    traceStats.Save(TraceStats::StatsFilename(pktTraceFilename));
 
     Simulator::Destroy ();
 }
 
 
-void
-run (string pktTraceFilename, vector<MultiLevelTable::Config> tableConfigs)
+/// the whole of `str` as a decimal integer, if it is one
+std::optional<int64_t>
+ParseInt (const string &str)
 {
-    nanoseconds statsDuration = nanoseconds{TraffDuration} / ( 2 * zip);
-    nanoseconds statsEndTs = 1s + nanoseconds{TraffDuration} / zip;
-    nanoseconds statsBeginTs = statsEndTs - statsDuration;
-
-    vector<std::unique_ptr<FlowTable>> flowTables;
-    for (int sz : {4'000, 20'000, 40'000, 80'000, 200'000}) {
-        auto tbl = std::make_unique<FlowTable>(sz, 1'000us);
-        tbl->SetStatsBeginTs(statsBeginTs);
-        flowTables.push_back(std::move(tbl));
+    int64_t value = 0;
+    auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (str.empty() || ec != std::errc{} || end != str.data() + str.size()) {
+        return {};
     }
+    return value;
+}
 
-    vector<std::unique_ptr<MultiLevelTable>> multiLevelTables;
-    for (const auto &cfg : tableConfigs) {
-        auto tbl = std::make_unique<MultiLevelTable>(cfg);
-        tbl->SetStatsBeginTs(statsBeginTs);
-        multiLevelTables.push_back(std::move(tbl));
+/// @brief Feed every packet of a trace to `callback`, in trace order.
+/// The trace is either GenPktTrace's binary output or a pcap/pcapng capture.
+/// @param replayFrom skip packets before this; GenPktTrace traces seek there through their TraceIndex
+/// @param replayUntil stop at the first packet at or after this
+/// @return false if the trace can not be opened
+template <class Callback>
+bool
+ForEachPkt (const string &pktTraceFilename, Callback &&callback, nanoseconds replayFrom = 0ns,
+            nanoseconds replayUntil = nanoseconds::max())
+{
+    if (PcapReader::IsCaptureFile(pktTraceFilename)) {
+        PcapReader reader{pktTraceFilename, threadCnt};
+        if (!reader.IsOpen()) {
+            std::cout << "Failed to open " << pktTraceFilename << std::endl;
+            return false;
+        }
+        vector<TcpPktMetadata> batch;
+        bool done = false;
+        while (!done && reader.NextBatch(batch)) {
+            for (const auto &pktMeta : batch) {
+                if (pktMeta.timestamp >= replayUntil) {
+                    done = true;
+                    break;
+                }
+                if (pktMeta.timestamp >= replayFrom) {
+                    callback(pktMeta);
+                }
+            }
+        }
+        std::cout << "pcap records=" << reader.GetRecordCnt()
+                << ", nonTcp=" << reader.GetNonTcpCnt()
+                << ", truncated=" << reader.GetTruncatedCnt()
+                << ", malformed=" << reader.GetMalformedCnt()
+                << std::endl;
+        return true;
     }
 
-
     std::ifstream pktTraceFile{pktTraceFilename, std::ios::binary};
     if (!pktTraceFile.is_open()) {
         std::cout << "Failed to open " << pktTraceFilename << std::endl;
-        return;
+        return false;
+    }
+    if (replayFrom > 0ns) {
+        pktTraceFile.seekg(TraceIndex::LoadOrBuild(pktTraceFilename).OffsetBefore(replayFrom));
     }
-
-    int64_t totalPktCnt = 0;
-    int64_t caredPktCnt = 0;
-    int64_t caredPhyByteCnt = 0;
     while (1) {
         std::optional pktMeta = TcpPktMetadata::FromFstream(pktTraceFile);
-        if (!pktMeta.has_value()) {
+        if (!pktMeta.has_value() || pktMeta->timestamp >= replayUntil) {
             break;
         }
-        totalPktCnt++;
+        if (pktMeta->timestamp >= replayFrom) {
+            callback(pktMeta.value());
+        }
+    }
+    return true;
+}
+
+/// where replays start for a stats window beginning at `statsBeginTs`, see `warmup`
+nanoseconds
+ReplayFrom (nanoseconds statsBeginTs)
+{
+    if (warmup < 0us) {
+        return 0ns;
+    }
+    return std::max(0ns, statsBeginTs - warmup);
+}
+
+
+/// @brief A table of the sweep, either replayed now or answered from ResultCache.
+template <class Table>
+struct SweepEntry {
+    string cacheKey;
+    string report;               // PrintStats output
+    std::unique_ptr<Table> tbl;  // null if `report` came from the cache
+};
 
-        nanoseconds now = pktMeta->timestamp;
-        if (now >= statsBeginTs) {
-            caredPktCnt++;
-            caredPhyByteCnt += pktMeta->phyPktSize;
+/// @brief FlowTables of FlowTableSizes plus MultiLevelTables of a sweep,
+/// fed the same packets; for modes that compare counters rather than reports.
+struct TableSet {
+    vector<std::unique_ptr<FlowTable>> flowTables;
+    vector<std::unique_ptr<MultiLevelTable>> multiLevelTables;
+
+    TableSet(const vector<MultiLevelTable::Config> &tableConfigs, nanoseconds statsBeginTs) {
+        for (int sz : FlowTableSizes) {
+            flowTables.push_back(std::make_unique<FlowTable>(sz, 1'000us));
+            flowTables.back()->SetStatsBeginTs(statsBeginTs);
         }
+        for (const auto &cfg : tableConfigs) {
+            multiLevelTables.push_back(std::make_unique<MultiLevelTable>(cfg));
+            multiLevelTables.back()->SetStatsBeginTs(statsBeginTs);
+        }
+    }
 
+    void DoRecord(const TcpPktMetadata &pktMeta) {
         for (auto &tbl : flowTables) {
-            tbl->DoRecord(pktMeta.value());
+            tbl->DoRecord(pktMeta);
         }
         for (auto &tbl : multiLevelTables) {
-            tbl->DoRecord(pktMeta.value());
+            tbl->DoRecord(pktMeta);
         }
     }
 
-    std::cout << "totalPktCnt=" << totalPktCnt
+    /// in the order of Labels()
+    vector<TableCounters> GetCounters() const {
+        vector<TableCounters> counters;
+        for (const auto &tbl : flowTables) {
+            counters.push_back(tbl->GetCounters());
+        }
+        for (const auto &tbl : multiLevelTables) {
+            counters.push_back(tbl->GetCounters());
+        }
+        return counters;
+    }
+
+    static vector<string> Labels(const vector<MultiLevelTable::Config> &tableConfigs) {
+        vector<string> labels;
+        for (int sz : FlowTableSizes) {
+            labels.push_back(FlowTable::ConfigKey(sz, 1'000us));
+        }
+        for (const auto &cfg : tableConfigs) {
+            labels.push_back(MultiLevelTable::ConfigKey(cfg));
+        }
+        return labels;
+    }
+};
+
+/// resident memory depends on the run, not the trace and config, so cached
+/// reports label it as measured by the run that stored them
+string
+MarkResidentMemoryCached (const string &report)
+{
+    std::istringstream in{report};
+    std::ostringstream out;
+    string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("memory: ", 0) == 0) {
+            line = "memory (cached run): " + line.substr(8);
+        }
+        out << line << '\n';
+    }
+    return out.str();
+}
+
+void
+run (string pktTraceFilename, vector<MultiLevelTable::Config> tableConfigs)
+{
+    nanoseconds statsDuration = nanoseconds{TraffDuration} / ( 2 * zip);
+    nanoseconds statsEndTs = 1s + nanoseconds{TraffDuration} / zip;
+    nanoseconds statsBeginTs = statsEndTs - statsDuration;
+
+    std::ostringstream runKey;
+    runKey << "statsBeginTs=" << statsBeginTs.count();
+    if (ReplayFrom(statsBeginTs) > 0ns) {
+        runKey << " replayFrom=" << ReplayFrom(statsBeginTs).count();
+    }
+    // time series are not cached, so a run dumping them replays every table
+    ResultCache cache{epochCsvFilename.empty() ? resultCacheDir : "", pktTraceFilename, runKey.str()};
+
+    int freshCnt = 0;
+    auto lookup = [&](auto &entry) {
+        if (auto report = cache.Lookup(entry.cacheKey)) {
+            entry.report = std::move(report.value());
+            return true;
+        }
+        freshCnt++;
+        return false;
+    };
+
+    vector<SweepEntry<FlowTable>> flowTables;
+    for (int sz : FlowTableSizes) {
+        SweepEntry<FlowTable> entry;
+        entry.cacheKey = FlowTable::ConfigKey(sz, 1'000us);
+        if (!lookup(entry)) {
+            entry.tbl = std::make_unique<FlowTable>(sz, 1'000us);
+            entry.tbl->SetStatsBeginTs(statsBeginTs);
+        }
+        flowTables.push_back(std::move(entry));
+    }
+    if (elasticResize.enabled) {
+        SweepEntry<FlowTable> entry;
+        entry.cacheKey = FlowTable::ConfigKey(ElasticInitSize, 1'000us, elasticResize);
+        if (!lookup(entry)) {
+            entry.tbl = std::make_unique<FlowTable>(ElasticInitSize, 1'000us, elasticResize);
+            entry.tbl->SetStatsBeginTs(statsBeginTs);
+        }
+        flowTables.push_back(std::move(entry));
+    }
+
+    vector<SweepEntry<MultiLevelTable>> multiLevelTables;
+    for (const auto &cfg : tableConfigs) {
+        SweepEntry<MultiLevelTable> entry;
+        entry.cacheKey = MultiLevelTable::ConfigKey(cfg);
+        if (!lookup(entry)) {
+            entry.tbl = std::make_unique<MultiLevelTable>(cfg);
+            entry.tbl->SetStatsBeginTs(statsBeginTs);
+        }
+        multiLevelTables.push_back(std::move(entry));
+    }
+
+    // sketches get the byte budget of the FlowTable of each size
+    FlowSizeTruth truth;
+    truth.SetStatsBeginTs(statsBeginTs);
+    vector<SweepEntry<CountMinSketch>> countMinSketches;
+    vector<SweepEntry<CountSketch>> countSketches;
+    vector<SweepEntry<ElasticSketch>> elasticSketches;
+    for (int sz : FlowTableSizes) {
+        size_t memBytes = sz * ExactCellBytes;
+
+        SweepEntry<CountMinSketch> cm;
+        cm.cacheKey = CountMinSketch::ConfigKey(memBytes, SketchDepth);
+        if (!lookup(cm)) {
+            cm.tbl = std::make_unique<CountMinSketch>(memBytes, SketchDepth, truth);
+            cm.tbl->SetStatsBeginTs(statsBeginTs);
+        }
+        countMinSketches.push_back(std::move(cm));
+
+        SweepEntry<CountSketch> cs;
+        cs.cacheKey = CountSketch::ConfigKey(memBytes, SketchDepth);
+        if (!lookup(cs)) {
+            cs.tbl = std::make_unique<CountSketch>(memBytes, SketchDepth, truth);
+            cs.tbl->SetStatsBeginTs(statsBeginTs);
+        }
+        countSketches.push_back(std::move(cs));
+
+        SweepEntry<ElasticSketch> es;
+        es.cacheKey = ElasticSketch::ConfigKey(memBytes, ElasticHeavyFraction);
+        if (!lookup(es)) {
+            es.tbl = std::make_unique<ElasticSketch>(memBytes, ElasticHeavyFraction, truth);
+            es.tbl->SetStatsBeginTs(statsBeginTs);
+        }
+        elasticSketches.push_back(std::move(es));
+    }
+    size_t sketchCnt = countMinSketches.size() + countSketches.size() + elasticSketches.size();
+    auto isFresh = [](const auto &entry) { return entry.tbl != nullptr; };
+    bool needTruth = std::any_of(countMinSketches.begin(), countMinSketches.end(), isFresh)
+                  || std::any_of(countSketches.begin(), countSketches.end(), isFresh)
+                  || std::any_of(elasticSketches.begin(), elasticSketches.end(), isFresh);
+
+    // the summary's concurrent flow distribution depends on the epoch length
+    const string summaryKey = "trace summary epochNs=" + std::to_string(EpochSeries::DefaultEpochDuration().count());
+    std::optional<string> summary = cache.Lookup(summaryKey);
+    std::cout << "result cache: " << (flowTables.size() + multiLevelTables.size() + sketchCnt - freshCnt)
+            << " hit, " << freshCnt << " to replay\n";
+
+    if (freshCnt > 0 || !summary.has_value()) {
+        int64_t totalPktCnt = 0;
+        int64_t caredPktCnt = 0;
+        int64_t caredPhyByteCnt = 0;
+        TraceStats traceStats{EpochSeries::DefaultEpochDuration()};
+        bool ok = ForEachPkt(pktTraceFilename, [&](const TcpPktMetadata &pktMeta) {
+            totalPktCnt++;
+
+            nanoseconds now = pktMeta.timestamp;
+            if (now >= statsBeginTs) {
+                caredPktCnt++;
+                caredPhyByteCnt += pktMeta.phyPktSize;
+                traceStats.Record(pktMeta);
+            }
+
+            for (auto &entry : flowTables) {
+                if (entry.tbl) entry.tbl->DoRecord(pktMeta);
+            }
+            for (auto &entry : multiLevelTables) {
+                if (entry.tbl) entry.tbl->DoRecord(pktMeta);
+            }
+            if (needTruth) truth.DoRecord(pktMeta);
+            for (auto &entry : countMinSketches) {
+                if (entry.tbl) entry.tbl->DoRecord(pktMeta);
+            }
+            for (auto &entry : countSketches) {
+                if (entry.tbl) entry.tbl->DoRecord(pktMeta);
+            }
+            for (auto &entry : elasticSketches) {
+                if (entry.tbl) entry.tbl->DoRecord(pktMeta);
+            }
+        }, ReplayFrom(statsBeginTs));
+        if (!ok) {
+            return;
+        }
+
+        std::ostringstream oss;
+        oss << "totalPktCnt=" << totalPktCnt
             << ", caredPktCnt=" << caredPktCnt
             << ", caredPhyByteCnt" << caredPhyByteCnt
             << "\n\n";
+        traceStats.Finish();
+        traceStats.Print(oss);
+        oss << "\n\n";
+        summary = oss.str();
+        cache.Store(summaryKey, summary.value());
+    }
 
-    for (const auto &tbl : flowTables) {
-        tbl->PrintStats();
+    auto finish = [&cache](auto &entry) {
+        if (entry.tbl) {
+            std::ostringstream oss;
+            entry.tbl->PrintStats(oss);
+            entry.report = oss.str();
+            cache.Store(entry.cacheKey, MarkResidentMemoryCached(entry.report));
+        }
+        std::cout << entry.report;
+    };
+    std::cout << summary.value();
+    for (auto &entry : flowTables) {
+        finish(entry);
+    }
+    std::cout << "\n\n\n\n\n";
+    for (auto &entry : multiLevelTables) {
+        finish(entry);
     }
     std::cout << "\n\n\n\n\n";
-    for (auto &tbl : multiLevelTables) {
+    for (size_t i = 0; i < FlowTableSizes.size(); i++) {
+        finish(countMinSketches[i]);
+        finish(countSketches[i]);
+        finish(elasticSketches[i]);
+    }
+
+    if (!epochCsvFilename.empty()) {
+        std::ofstream epochCsv{epochCsvFilename};
+        if (!epochCsv.is_open()) {
+            std::cout << "Failed to open " << epochCsvFilename << std::endl;
+            return;
+        }
+        EpochSeries::PrintCsvHeader(epochCsv);
+        for (const auto &entry : flowTables) {
+            if (entry.tbl) entry.tbl->PrintEpochCsv(epochCsv);
+        }
+        for (const auto &entry : multiLevelTables) {
+            if (entry.tbl) entry.tbl->PrintEpochCsv(epochCsv);
+        }
+    }
+}
+
+
+/// @brief Replay the trace into shared tables from `threadCnt` workers,
+/// each worker taking the packets of an RSS-style partition (by flow hash).
+void
+runConcurrent (string pktTraceFilename, vector<MultiLevelTable::Config> tableConfigs)
+{
+    nanoseconds statsDuration = nanoseconds{TraffDuration} / ( 2 * zip);
+    nanoseconds statsEndTs = 1s + nanoseconds{TraffDuration} / zip;
+    nanoseconds statsBeginTs = statsEndTs - statsDuration;
+
+    vector<std::unique_ptr<ConcurrentMultiLevelTable>> tables;
+    for (const auto &cfg : tableConfigs) {
+        if (cfg.policy != MultiLevelTable::ReplacePolicy::Ewma || cfg.resize.enabled) {
+            continue; // only fixed-size tables with the alpha policies have a concurrent version
+        }
+        auto tbl = std::make_unique<ConcurrentMultiLevelTable>(cfg, threadCnt);
+        tbl->SetStatsBeginTs(statsBeginTs);
+        tables.push_back(std::move(tbl));
+    }
+
+    // partition up front, so that workers only contend on the tables
+    vector<vector<TcpPktMetadata>> slices(threadCnt);
+    int64_t totalPktCnt = 0;
+    bool ok = ForEachPkt(pktTraceFilename, [&](const TcpPktMetadata &pktMeta) {
+        totalPktCnt++;
+        slices[pktMeta.flow.GetHashValue() % threadCnt].push_back(pktMeta);
+    }, ReplayFrom(statsBeginTs));
+    if (!ok) {
+        return;
+    }
+
+    auto beginTime = std::chrono::steady_clock::now();
+    vector<std::thread> workers;
+    for (int w = 0; w < threadCnt; w++) {
+        workers.emplace_back([&tables, &slices, w]() {
+            for (const auto &pktMeta : slices[w]) {
+                for (auto &tbl : tables) {
+                    tbl->DoRecord(pktMeta, w);
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - beginTime;
+
+    std::cout << "totalPktCnt=" << totalPktCnt
+            << ", threads=" << threadCnt
+            << ", replayTime=" << std::chrono::duration_cast<milliseconds>(elapsed)
+            << "\n\n";
+    for (auto &tbl : tables) {
         tbl->PrintStats();
     }
 }
 
 
+/// @brief Replay each table alone, paced by packet timestamps against the
+/// wall clock, to measure per-packet latency and line-rate headroom.
+void
+runPaced (string pktTraceFilename, vector<MultiLevelTable::Config> tableConfigs)
+{
+    nanoseconds statsDuration = nanoseconds{TraffDuration} / ( 2 * zip);
+    nanoseconds statsEndTs = 1s + nanoseconds{TraffDuration} / zip;
+    nanoseconds statsBeginTs = statsEndTs - statsDuration;
+
+    // load up front, so that trace I/O is not part of the paced loop
+    vector<TcpPktMetadata> pkts;
+    bool ok = ForEachPkt(pktTraceFilename, [&pkts](const TcpPktMetadata &pktMeta) {
+        pkts.push_back(pktMeta);
+    }, ReplayFrom(statsBeginTs));
+    if (!ok) {
+        return;
+    }
+    std::cout << "totalPktCnt=" << pkts.size()
+            << ", speedup=" << paceSpeedup
+            << ", maxQueueDelay=" << maxQueueDelay
+            << "\n\n";
+
+    for (int sz : FlowTableSizes) {
+        FlowTable tbl{sz, 1'000us};
+        tbl.SetStatsBeginTs(statsBeginTs);
+        auto result = PacedReplay(tbl, pkts, paceSpeedup, maxQueueDelay);
+        tbl.PrintStats();
+        result.Print();
+        std::cout << std::endl;
+    }
+    std::cout << "\n\n\n\n\n";
+    for (const auto &cfg : tableConfigs) {
+        MultiLevelTable tbl{cfg};
+        tbl.SetStatsBeginTs(statsBeginTs);
+        auto result = PacedReplay(tbl, pkts, paceSpeedup, maxQueueDelay);
+        tbl.PrintStats();
+        result.Print();
+        std::cout << std::endl;
+    }
+}
+
+
+/// @brief Replay a multi-port trace with a separate set of tables per port,
+/// as if every egress port had its own flow memory. Ports are spread over
+/// `threadCnt` workers, which share nothing but the trace. Each config is
+/// then reported summed over ports, followed by its per-port breakdown.
+void
+runPorts (string pktTraceFilename, vector<MultiLevelTable::Config> tableConfigs)
+{
+    nanoseconds statsDuration = nanoseconds{TraffDuration} / ( 2 * zip);
+    nanoseconds statsEndTs = 1s + nanoseconds{TraffDuration} / zip;
+    nanoseconds statsBeginTs = statsEndTs - statsDuration;
+
+    vector<vector<TcpPktMetadata>> slices;
+    int64_t totalPktCnt = 0;
+    bool ok = ForEachPkt(pktTraceFilename, [&](const TcpPktMetadata &pktMeta) {
+        totalPktCnt++;
+        if (pktMeta.portId >= slices.size()) {
+            slices.resize(pktMeta.portId + 1);
+        }
+        slices[pktMeta.portId].push_back(pktMeta);
+    }, ReplayFrom(statsBeginTs));
+    if (!ok) {
+        return;
+    }
+    int ports = slices.size();
+    if (ports == 0) {
+        std::cout << "totalPktCnt=0, no packets to replay\n";
+        return;
+    }
+
+    vector<vector<TableCounters>> portCounters(ports);
+    vector<int64_t> portCaredPktCnts(ports);
+    std::atomic<int> nextPort{0};
+    auto beginTime = std::chrono::steady_clock::now();
+    vector<std::thread> workers;
+    for (int w = 0; w < std::min(threadCnt, ports); w++) {
+        workers.emplace_back([&]() {
+            for (int port = nextPort++; port < ports; port = nextPort++) {
+                // tables only live while their port is replayed, to bound memory by threadCnt
+                TableSet tables{tableConfigs, statsBeginTs};
+                int64_t caredPktCnt = 0;
+                for (const auto &pktMeta : slices[port]) {
+                    if (pktMeta.timestamp >= statsBeginTs) {
+                        caredPktCnt++;
+                    }
+                    tables.DoRecord(pktMeta);
+                }
+                portCaredPktCnts[port] = caredPktCnt;
+                portCounters[port] = tables.GetCounters();
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - beginTime;
+
+    std::cout << "totalPktCnt=" << totalPktCnt
+            << ", ports=" << ports
+            << ", threads=" << threadCnt
+            << ", replayTime=" << std::chrono::duration_cast<milliseconds>(elapsed)
+            << "\n";
+    std::cout << "caredPktCnt per port:";
+    for (int port = 0; port < ports; port++) {
+        std::cout << " " << portCaredPktCnts[port];
+    }
+    std::cout << "\n\n";
+
+    vector<string> labels = TableSet::Labels(tableConfigs);
+    for (size_t i = 0; i < labels.size(); i++) {
+        TableCounters total;
+        for (int port = 0; port < ports; port++) {
+            total += portCounters[port][i];
+        }
+        std::cout << "======== " << labels[i] << ", ports=" << ports << " ========\n";
+        std::cout << "total: records=" << total.records
+                << ", expirs=" << total.expirs
+                << ", evicts=" << total.evicts
+                << ", occupancy=" << total.occupancy
+                << ", memory=" << total.memBytes / 1024 << "KB"
+                << " (" << ports << " x " << total.memBytes / ports / 1024 << "KB)"
+                << std::endl;
+        for (int port = 0; port < ports; port++) {
+            const TableCounters &c = portCounters[port][i];
+            std::cout << "port " << port
+                    << ": records=" << c.records
+                    << ", expirs=" << c.expirs
+                    << ", evicts=" << c.evicts
+                    << ", occupancy=" << c.occupancy
+                    << std::endl;
+        }
+        std::cout << std::endl;
+    }
+}
+
+/// @brief TTL what-ifs without a full replay per variant. One base table per
+/// FlowTable size and per MultiLevelTable geometry replays the trace up to
+/// `forkAt` and is snapshotted there; every variant (each of `whatIfTtls`,
+/// and each sweep config sharing the base's geometry) is then restored from
+/// its base's snapshot and replays only the suffix up to the end of the
+/// stats window, over `threadCnt` workers.
+/// Variants behave as their base up to the fork and as themselves after it.
+void
+runWhatIf (string pktTraceFilename, vector<MultiLevelTable::Config> tableConfigs)
+{
+    nanoseconds statsDuration = nanoseconds{TraffDuration} / ( 2 * zip);
+    nanoseconds statsEndTs = 1s + nanoseconds{TraffDuration} / zip;
+    nanoseconds statsBeginTs = statsEndTs - statsDuration;
+    nanoseconds forkTs = (forkAt < 0us) ? statsBeginTs : nanoseconds{forkAt};
+
+    vector<microseconds> ttls;
+    std::istringstream ttlList{whatIfTtls};
+    string ttlUs;
+    while (std::getline(ttlList, ttlUs, ',')) {
+        std::optional<int64_t> ttl = ParseInt(ttlUs);
+        if (!ttl.has_value()) {
+            std::cerr << "unexpected whatIfTtls entry '" << ttlUs << "' (should be an integer, in us)\n";
+            exit(1);
+        }
+        ttls.push_back(microseconds{ttl.value()});
+    }
+    if (forkTs >= statsEndTs) {
+        std::cerr << "'whatIf' needs --forkAt before the end of the stats window ("
+                  << std::chrono::duration_cast<microseconds>(statsEndTs) << ")\n";
+        return;
+    }
+
+    // bases, one per geometry; elastic tables change geometry and can't be forked
+    vector<std::unique_ptr<FlowTable>> flowBases;
+    for (int sz : FlowTableSizes) {
+        flowBases.push_back(std::make_unique<FlowTable>(sz, 1'000us));
+        flowBases.back()->SetStatsBeginTs(statsBeginTs);
+    }
+    std::map<string, std::unique_ptr<MultiLevelTable>> multiLevelBases;
+    for (const auto &cfg : tableConfigs) {
+        if (cfg.resize.enabled) {
+            continue;
+        }
+        auto &base = multiLevelBases[MultiLevelTable::SnapshotKey(cfg)];
+        if (!base) {
+            base = std::make_unique<MultiLevelTable>(cfg);
+            base->SetStatsBeginTs(statsBeginTs);
+        }
+    }
+
+    int64_t prefixPktCnt = 0;
+    auto beginTime = std::chrono::steady_clock::now();
+    bool ok = ForEachPkt(pktTraceFilename, [&](const TcpPktMetadata &pktMeta) {
+        prefixPktCnt++;
+        for (auto &tbl : flowBases) {
+            tbl->DoRecord(pktMeta);
+        }
+        for (auto &[key, tbl] : multiLevelBases) {
+            tbl->DoRecord(pktMeta);
+        }
+    }, std::min(ReplayFrom(statsBeginTs), forkTs), forkTs);
+    if (!ok) {
+        return;
+    }
+
+    vector<TableSnapshot> flowSnapshots(flowBases.size());
+    for (size_t i = 0; i < flowBases.size(); i++) {
+        flowSnapshots[i].traceTs = forkTs;
+        flowBases[i]->Snapshot(flowSnapshots[i]);
+    }
+    flowBases.clear();
+    std::map<string, TableSnapshot> multiLevelSnapshots;
+    size_t snapshotBytes = 0;
+    for (auto &[key, tbl] : multiLevelBases) {
+        TableSnapshot &snapshot = multiLevelSnapshots[key];
+        snapshot.traceTs = forkTs;
+        tbl->Snapshot(snapshot);
+        snapshotBytes += snapshot.Size();
+    }
+    multiLevelBases.clear();
+    for (const auto &snapshot : flowSnapshots) {
+        snapshotBytes += snapshot.Size();
+    }
+    auto prefixTime = std::chrono::steady_clock::now() - beginTime;
+
+    // shared by all workers, so bounded by the stats window (where GenPktTrace traces end anyway)
+    vector<TcpPktMetadata> suffix;
+    ok = ForEachPkt(pktTraceFilename, [&suffix](const TcpPktMetadata &pktMeta) {
+        suffix.push_back(pktMeta);
+    }, forkTs, statsEndTs);
+    if (!ok) {
+        return;
+    }
+
+    // one task per variant; a worker only holds the table it is replaying
+    vector<std::function<string()>> tasks;
+    for (size_t i = 0; i < FlowTableSizes.size(); i++) {
+        for (microseconds ttl : ttls) {
+            tasks.push_back([&, i, ttl]() {
+                FlowTable tbl{FlowTableSizes[i], ttl};
+                if (!tbl.Restore(flowSnapshots[i])) {
+                    return string{"failed to restore " + FlowTable::ConfigKey(FlowTableSizes[i], ttl) + "\n"};
+                }
+                for (const auto &pktMeta : suffix) {
+                    tbl.DoRecord(pktMeta);
+                }
+                std::ostringstream oss;
+                tbl.PrintStats(oss);
+                return oss.str();
+            });
+        }
+    }
+    for (const auto &cfg : tableConfigs) {
+        if (cfg.resize.enabled) {
+            continue;
+        }
+        for (microseconds ttl : ttls) {
+            MultiLevelTable::Config variant = cfg;
+            variant.ttl = ttl;
+            tasks.push_back([&, variant]() {
+                MultiLevelTable tbl{variant};
+                if (!tbl.Restore(multiLevelSnapshots.at(MultiLevelTable::SnapshotKey(variant)))) {
+                    return string{"failed to restore " + MultiLevelTable::ConfigKey(variant) + "\n"};
+                }
+                for (const auto &pktMeta : suffix) {
+                    tbl.DoRecord(pktMeta);
+                }
+                std::ostringstream oss;
+                tbl.PrintStats(oss);
+                return oss.str();
+            });
+        }
+    }
+
+    vector<string> reports(tasks.size());
+    std::atomic<size_t> nextTask{0};
+    beginTime = std::chrono::steady_clock::now();
+    vector<std::thread> workers;
+    for (int w = 0; w < threadCnt; w++) {
+        workers.emplace_back([&]() {
+            for (size_t task = nextTask++; task < tasks.size(); task = nextTask++) {
+                reports[task] = tasks[task]();
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    auto suffixTime = std::chrono::steady_clock::now() - beginTime;
+
+    auto ms = [](auto d) { return std::chrono::duration_cast<milliseconds>(d); };
+    std::cout << "fork at " << std::chrono::duration_cast<microseconds>(forkTs)
+            << ": prefix " << prefixPktCnt << " pkts into "
+            << flowSnapshots.size() + multiLevelSnapshots.size() << " bases in " << ms(prefixTime)
+            << ", snapshots " << snapshotBytes / 1024 << "KB\n";
+    std::cout << "suffix " << suffix.size() << " pkts into " << tasks.size() << " variants"
+            << " in " << ms(suffixTime) << " (threads=" << threadCnt << ")\n\n";
+    for (const auto &report : reports) {
+        std::cout << report;
+    }
+}
+
+/// @brief Replay the sweep from the first packet and again from `warmup`
+/// before the stats window, and report how far the windowed counters are
+/// off, to check that the warm-up margin is long enough for the trace.
+void
+validateWarmup (string pktTraceFilename, vector<MultiLevelTable::Config> tableConfigs)
+{
+    nanoseconds statsDuration = nanoseconds{TraffDuration} / ( 2 * zip);
+    nanoseconds statsEndTs = 1s + nanoseconds{TraffDuration} / zip;
+    nanoseconds statsBeginTs = statsEndTs - statsDuration;
+    if (warmup < 0us) {
+        std::cerr << "'validateWarmup' needs --warmup\n";
+        return;
+    }
+
+    struct Replay {
+        int64_t pktCnt = 0;
+        std::chrono::steady_clock::duration elapsed{};
+        vector<TableCounters> counters;
+    };
+    auto replay = [&](nanoseconds replayFrom, Replay &result) {
+        TableSet tables{tableConfigs, statsBeginTs};
+        auto beginTime = std::chrono::steady_clock::now();
+        bool ok = ForEachPkt(pktTraceFilename, [&](const TcpPktMetadata &pktMeta) {
+            result.pktCnt++;
+            tables.DoRecord(pktMeta);
+        }, replayFrom);
+        result.elapsed = std::chrono::steady_clock::now() - beginTime;
+        result.counters = tables.GetCounters();
+        return ok;
+    };
+    Replay full, windowed;
+    if (!replay(0ns, full) || !replay(ReplayFrom(statsBeginTs), windowed)) {
+        return;
+    }
+
+    auto ms = [](auto d) { return std::chrono::duration_cast<milliseconds>(d); };
+    std::cout << "full replay: " << full.pktCnt << " pkts in " << ms(full.elapsed) << "\n";
+    std::cout << "windowed replay from " << std::chrono::duration_cast<microseconds>(ReplayFrom(statsBeginTs))
+            << " (warmup=" << warmup << "): "
+            << windowed.pktCnt << " pkts in " << ms(windowed.elapsed)
+            << ", " << (double)full.elapsed.count() / std::max<int64_t>(1, windowed.elapsed.count()) << "x faster"
+            << "\n\n";
+
+    // relative error of the windowed counter against the full replay
+    auto relErr = [](int64_t windowedCnt, int64_t fullCnt) {
+        return std::abs((double)(windowedCnt - fullCnt)) / std::max<int64_t>(1, fullCnt);
+    };
+    double maxErr = 0;
+    string maxErrLabel;
+    vector<string> labels = TableSet::Labels(tableConfigs);
+    for (size_t i = 0; i < labels.size(); i++) {
+        const TableCounters &f = full.counters[i];
+        const TableCounters &w = windowed.counters[i];
+        double err = std::max({relErr(w.records, f.records), relErr(w.expirs, f.expirs), relErr(w.evicts, f.evicts)});
+        if (err > maxErr) {
+            maxErr = err;
+            maxErrLabel = labels[i];
+        }
+        std::cout << labels[i] << ": records " << f.records << " -> " << w.records
+                << ", expirs " << f.expirs << " -> " << w.expirs
+                << ", evicts " << f.evicts << " -> " << w.evicts
+                << ", maxRelErr=" << err
+                << std::endl;
+    }
+    std::cout << "\nmax relative error: " << maxErr;
+    if (!maxErrLabel.empty()) {
+        std::cout << " (" << maxErrLabel << ")";
+    }
+    std::cout << std::endl;
+}
+
+vector<MultiLevelTable::Config>
+SweepTableConfigs ()
+{
+    using ReplacePolicy = MultiLevelTable::ReplacePolicy;
+    static const std::map<string, ReplacePolicy> PolicyNames{
+        {"ewma", ReplacePolicy::Ewma}, {"lru", ReplacePolicy::Lru},
+        {"minPkt", ReplacePolicy::MinPkt}, {"minByte", ReplacePolicy::MinByte},
+        {"shiftEwma", ReplacePolicy::ShiftEwma}, {"probDecay", ReplacePolicy::ProbDecay}};
+
+    // every policy variant of the sweep, crossed with the table shapes below
+    vector<MultiLevelTable::Config> variants;
+    MultiLevelTable::Config config;
+    config.ttl = 1ms;
+    config.alpha = -1.0;
+    std::istringstream policies{replacePolicies};
+    string name;
+    while (std::getline(policies, name, ',')) {
+        auto it = PolicyNames.find(name);
+        if (it == PolicyNames.end()) {
+            std::cerr << "unexpected replace policy '" << name
+                      << "' (should be 'ewma', 'lru', 'minPkt', 'minByte', 'shiftEwma' or 'probDecay')\n";
+            exit(1);
+        }
+        config.policy = it->second;
+        if (config.policy == ReplacePolicy::Ewma) {
+            for (double alpha : {-1.0, 0.25, 0.5, 0.75, 1.0}) {
+                config.alpha = alpha;
+                variants.push_back(config);
+            }
+            config.alpha = -1.0;
+        } else if (config.policy == ReplacePolicy::ShiftEwma) {
+            for (int alphaShift : {1, 2}) {
+                config.alphaShift = alphaShift;
+                variants.push_back(config);
+            }
+        } else {
+            variants.push_back(config);
+        }
+    }
+
+    vector<MultiLevelTable::Config> tableConfigs;
+    for (auto variant : variants) {
+        for (bool diffHashFunc : {false, true}) {
+            variant.diffHashFunc = diffHashFunc;
+            for (int colCnt : {2, 3, 4}) {
+                variant.colCnt = colCnt;
+                for (int rowCnt : {4'000, 20'000, 40'000, 80'000, 200'000}) {
+                    variant.rowCnt = rowCnt;
+                    tableConfigs.push_back(variant);
+                }
+                if (elasticResize.enabled) {
+                    auto elastic = variant;
+                    elastic.rowCnt = ElasticInitSize;
+                    elastic.resize = elasticResize;
+                    tableConfigs.push_back(elastic);
+                }
+            }
+        }
+    }
+    return tableConfigs;
+}
+
+string
+PktTraceFilename (const string &traffModel, int zip)
+{
+    std::ostringstream oss;
+    oss << "scratch/measure-sim/pktTrace-" << traffModel << "-" << zip << "x";
+    if (portCnt > 1) {
+        oss << "-" << portCnt << "port";
+    }
+    oss << ".bin";
+    return oss.str();
+}
+
+string
+TraffFilename (const string &traffModel)
+{
+    return "scratch/measure-sim/traff-" + traffModel + "-100Gbps.txt";
+}
+
+
+/// @brief Run every (model, zip) job of `jobList` ("AliStorage:1,GoogleRPC:2")
+/// as child processes of this binary: 'genTrace' when the trace is missing,
+/// then 'run'. Generating a trace overlaps with replaying earlier ones.
+/// @param passArgs options forwarded to every child
+/// @return process exit code
+int
+runBatch (const string &jobList, const vector<string> &passArgs,
+          int workerCnt, size_t memBudget, const string &reportFilename)
+{
+    // rough peak memory of ns-3 simulating one BulkSend flow
+    constexpr size_t GenMemPerFlow = 16 << 10;
+    constexpr size_t BaseMem = 64 << 20;
+
+    size_t runMem = BaseMem;
+    for (int sz : FlowTableSizes) {
+        runMem += FlowTable::MemoryBytes(sz);
+    }
+    runMem += FlowTable::MemoryBytes(ElasticInitSize, elasticResize);
+    for (const auto &cfg : SweepTableConfigs()) {
+        runMem += MultiLevelTable::MemoryBytes(cfg);
+    }
+    for (int sz : FlowTableSizes) {
+        runMem += 3 * sz * ExactCellBytes; // sketches
+    }
+
+    string self = fs::read_symlink("/proc/self/exe").string();
+    fs::path logDir{"scratch/measure-sim/batch-logs"};
+    fs::create_directories(logDir);
+
+    JobScheduler scheduler{workerCnt, memBudget};
+    vector<pair<string, int>> runTasks; // job name, task id
+    vector<string> traceFilenames;
+    std::set<string> jobNames;
+    std::istringstream jobs{jobList};
+    string job;
+    while (std::getline(jobs, job, ',')) {
+        auto colon = job.find(':');
+        if (colon == string::npos) {
+            std::cerr << "unexpected job '" << job << "' (should be model:zip)\n";
+            return 1;
+        }
+        string model = job.substr(0, colon);
+        std::optional<int64_t> jobZip = ParseInt(job.substr(colon + 1));
+        if (!jobZip.has_value() || jobZip.value() < 1 || jobZip.value() > INT32_MAX) {
+            std::cerr << "unexpected job '" << job << "' (zip should be a positive integer)\n";
+            return 1;
+        }
+        string name = model + "-" + std::to_string(jobZip.value()) + "x";
+        if (!jobNames.insert(name).second) {
+            // a second run would only regenerate and replay the same trace concurrently
+            std::cerr << "skipping duplicate job '" << job << "'\n";
+            continue;
+        }
+
+        vector<string> argv{self, "--traff=" + model, "--zip=" + std::to_string(jobZip.value())};
+        argv.insert(argv.end(), passArgs.begin(), passArgs.end());
+
+        JobScheduler::Task runTask;
+        runTask.name = "run " + name;
+        runTask.argv = argv;
+        runTask.argv.push_back("run");
+        runTask.logFilename = (logDir / (name + "-run.log")).string();
+        runTask.memBytes = runMem;
+
+        traceFilenames.push_back(PktTraceFilename(model, jobZip.value()));
+        if (!fs::exists(traceFilenames.back())) {
+            std::ifstream traffFile{TraffFilename(model)};
+            int flowCnt = 0;
+            traffFile >> flowCnt;
+
+            JobScheduler::Task genTask;
+            genTask.name = "genTrace " + name;
+            genTask.argv = argv;
+            genTask.argv.push_back("genTrace");
+            genTask.logFilename = (logDir / (name + "-genTrace.log")).string();
+            genTask.memBytes = BaseMem + flowCnt * GenMemPerFlow;
+            runTask.deps.push_back(scheduler.AddTask(genTask));
+        }
+        runTasks.push_back({name, scheduler.AddTask(runTask)});
+    }
+
+    bool allOk = scheduler.Run();
+
+    std::ofstream report{reportFilename};
+    for (const auto &[name, id] : runTasks) {
+        std::ostringstream section;
+        section << "######## job " << name
+                << (scheduler.Succeeded(id) ? "" : " (FAILED)")
+                << " ########\n";
+        std::ifstream log{scheduler.GetTask(id).logFilename};
+        section << log.rdbuf() << "\n";
+        report << section.str();
+        std::cout << section.str();
+    }
+
+    // one distribution over all traces; stats files are saved by genTrace
+    TraceStats mergedStats;
+    int mergedCnt = 0;
+    for (const auto &traceFilename : traceFilenames) {
+        if (auto stats = TraceStats::Load(TraceStats::StatsFilename(traceFilename))) {
+            mergedStats.Merge(stats.value());
+            mergedCnt++;
+        }
+    }
+    if (mergedCnt > 0) {
+        std::ostringstream section;
+        section << "######## merged trace stats of " << mergedCnt << " traces ########\n";
+        mergedStats.Print(section);
+        report << section.str();
+        std::cout << section.str();
+    }
+    std::cout << "report written to " << reportFilename << std::endl;
+    return allOk ? 0 : 1;
+}
+
+
 int
 main (int argc, char *argv[])
 {
     string traffModel{"AliStorage"};
     string mode{"run"};
+    string pktTraceFilename;
+    string hugePages{"thp"};
+    int numaNode = -1;
+    int64_t epochUs = EpochSeries::DefaultEpochDuration().count() / 1000;
+    string jobList{"AliStorage:1,GoogleRPC:1"};
+    int batchWorkerCnt = 2;
+    int64_t memBudgetMB = 16 << 10;
+    string reportFilename{"scratch/measure-sim/batch-report.txt"};
+    string elastic{"none"};
 
     CommandLine cmd (__FILE__);
     cmd.AddValue("traff", "traffic model (e.g. AliStorage, GoogleRPC, ...)", traffModel);
     cmd.AddValue("zip", "zip ratio (e.g. 1, 2, 4, ...)", zip);
-    cmd.AddNonOption("mode", "'run' or 'genTrace'", mode);
+    cmd.AddValue("threads", "worker threads for 'runConcurrent', 'runPorts' and pcap decoding", threadCnt);
+    cmd.AddValue("ports", "egress ports (receivers) of the fabric 'genTrace' simulates", portCnt);
+    cmd.AddValue("trace", "replay this trace (GenPktTrace .bin, .pcap or .pcapng) instead", pktTraceFilename);
+    cmd.AddValue("hugePages", "table memory pages: 'none', 'thp' or 'explicit'", hugePages);
+    cmd.AddValue("numaNode", "NUMA node for table memory (negative: first touch)", numaNode);
+    cmd.AddValue("epoch", "epoch length (us) of per-table time series", epochUs);
+    cmd.AddValue("epochCsv", "dump per-epoch table counters of 'run' to this CSV file", epochCsvFilename);
+    cmd.AddValue("resultCache", "directory caching per-table results of 'run' (empty: disabled; bypassed by --epochCsv)", resultCacheDir);
+    cmd.AddValue("speedup", "replay speed-up over trace timestamps for 'runPaced'", paceSpeedup);
+    int64_t maxQueueDelayUs = maxQueueDelay.count();
+    cmd.AddValue("maxQueueDelay", "queueing delay (us) treated as a queue building up in 'runPaced'", maxQueueDelayUs);
+    cmd.AddValue("policies", "MultiLevelTable replace policies to sweep, comma separated "
+                 "(ewma, lru, minPkt, minByte, shiftEwma, probDecay)", replacePolicies);
+    cmd.AddValue("elastic", "also sweep tables resizing online: 'none', 'evictRate' or 'occupancy'", elastic);
+    int64_t warmupUs = warmup.count();
+    cmd.AddValue("warmup", "start replays this long (us) before the stats window (negative: from the first packet)", warmupUs);
+    int64_t forkAtUs = forkAt.count();
+    cmd.AddValue("forkAt", "where (us) 'whatIf' snapshots its base tables (negative: the stats window)", forkAtUs);
+    cmd.AddValue("whatIfTtls", "TTLs (us) 'whatIf' forks every base table into, comma separated", whatIfTtls);
+    cmd.AddValue("jobs", "model:zip jobs of 'batch', comma separated", jobList);
+    cmd.AddValue("workers", "concurrent processes of 'batch'", batchWorkerCnt);
+    cmd.AddValue("memBudget", "memory budget (MB) of concurrent 'batch' processes", memBudgetMB);
+    cmd.AddValue("report", "combined report of 'batch'", reportFilename);
+    cmd.AddNonOption("mode", "'run', 'runConcurrent', 'runPaced', 'runPorts', 'validateWarmup', 'whatIf', "
+                     "'genTrace' or 'batch'", mode);
     cmd.Parse (argc, argv);
+    maxQueueDelay = microseconds{maxQueueDelayUs};
+    warmup = microseconds{warmupUs};
+    forkAt = microseconds{forkAtUs};
+    if (portCnt < 1 || portCnt > 256) {
+        std::cerr << "unexpected ports " << portCnt << " (should be 1 ~ 256)\n";
+        exit(1);
+    }
+    if (epochUs <= 0) {
+        std::cerr << "unexpected epoch " << epochUs << " (should be positive)\n";
+        exit(1);
+    }
+    if (threadCnt < 1) {
+        std::cerr << "unexpected threads " << threadCnt << " (should be positive)\n";
+        exit(1);
+    }
+    if (!(paceSpeedup > 0) || std::isinf(paceSpeedup)) {
+        std::cerr << "unexpected speedup " << paceSpeedup << " (should be positive)\n";
+        exit(1);
+    }
+    if (maxQueueDelay < 0us) {
+        std::cerr << "unexpected maxQueueDelay " << maxQueueDelay << " (should not be negative)\n";
+        exit(1);
+    }
+
+    if (elastic == "evictRate") {
+        elasticResize.trigger = ResizePolicy::Trigger::EvictRate;
+        elasticResize.growThreshold = 0.01;
+        elasticResize.shrinkThreshold = 0.001;
+    } else if (elastic == "occupancy") {
+        elasticResize.trigger = ResizePolicy::Trigger::Occupancy;
+        elasticResize.growThreshold = 0.75;
+        elasticResize.shrinkThreshold = 0.25;
+    } else if (elastic != "none") {
+        std::cerr << "unexpected elastic '" << elastic << "' (should be 'none', 'evictRate' or 'occupancy')\n";
+        exit(1);
+    }
+    elasticResize.enabled = (elastic != "none");
+    elasticResize.minRows = FlowTableSizes.front();
+    elasticResize.maxRows = FlowTableSizes.back();
+
+    if (mode == "batch") {
+        vector<string> passArgs;
+        for (int i = 1; i < argc; i++) {
+            string arg{argv[i]};
+            string name = arg.substr(0, arg.find('='));
+            static const std::set<string> batchOnly{
+                "--traff", "--zip", "--trace", "--jobs", "--workers", "--memBudget", "--report"};
+            if (arg.rfind("--", 0) == 0 && batchOnly.count(name) == 0) {
+                passArgs.push_back(arg);
+            }
+        }
+        return runBatch(jobList, passArgs, batchWorkerCnt, (size_t)memBudgetMB << 20, reportFilename);
+    }
 
     if (traffModel == "AliStorage") {
         TraffDuration = 1000ms;
@@ -273,43 +1328,61 @@ main (int argc, char *argv[])
         exit(1);
     }
 
+    auto &arenaOptions = TableArena::DefaultOptions();
+    if (hugePages == "none") {
+        arenaOptions.pageMode = TableArena::PageMode::Default;
+    } else if (hugePages == "thp") {
+        arenaOptions.pageMode = TableArena::PageMode::TransparentHuge;
+    } else if (hugePages == "explicit") {
+        arenaOptions.pageMode = TableArena::PageMode::ExplicitHuge;
+    } else {
+        std::cerr << "unexpected hugePages '" << hugePages << "' (should be 'none', 'thp' or 'explicit')\n";
+        exit(1);
+    }
+    // the mbind mask is one unsigned long, and a node that doesn't exist would be ignored silently
+    if (numaNode >= 64 || (numaNode >= 0 && !fs::exists("/sys/devices/system/node/node" + std::to_string(numaNode)))) {
+        std::cerr << "unexpected numaNode " << numaNode << " (no such NUMA node)\n";
+        exit(1);
+    }
+    arenaOptions.numaNode = numaNode;
+    EpochSeries::DefaultEpochDuration() = microseconds{epochUs};
+
     std::cout << "========"
             << " model=" << traffModel
             << "-" << zip << "x"
             << " ========\n";
 
-    std::ostringstream oss;
-    oss << "scratch/measure-sim/pktTrace-" << traffModel << "-" << zip << "x.bin";
-    string pktTraceFilename = oss.str();
-    string traffFilename = "scratch/measure-sim/traff-" + traffModel + "-100Gbps.txt";
+    if (pktTraceFilename.empty()) {
+        pktTraceFilename = PktTraceFilename(traffModel, zip);
+    }
+    string traffFilename = TraffFilename(traffModel);
 
     if (mode == "genTrace") {
         GenPktTrace(traffFilename, pktTraceFilename);
         return 0;
-    } else if (mode != "run") {
-        std::cerr << "unexpected mode '" << mode << "' (should be 'run' or 'genTrace')\n";
+    } else if (mode != "run" && mode != "runConcurrent" && mode != "runPaced" && mode != "runPorts"
+               && mode != "validateWarmup" && mode != "whatIf") {
+        std::cerr << "unexpected mode '" << mode << "' (should be 'run', 'runConcurrent', 'runPaced', 'runPorts', "
+                  << "'validateWarmup', 'whatIf', 'genTrace' or 'batch')\n";
     }
 
-    if (!fs::exists(pktTraceFilename)) {
+    if (!fs::exists(pktTraceFilename) && !PcapReader::IsCaptureFile(pktTraceFilename)) {
         std::cerr << "pkt trace file not found. generating it...\n";
         GenPktTrace(traffFilename, pktTraceFilename);
     }
 
-    vector<MultiLevelTable::Config> tableConfigs;
-    MultiLevelTable::Config config;
-    config.ttl = 1ms;
-    for (double alpha : {-1.0, 0.25, 0.5, 0.75, 1.0}) {
-        config.alpha = alpha;
-        for (bool diffHashFunc : {false, true}) {
-            config.diffHashFunc = diffHashFunc;
-            for (int colCnt : {2, 3, 4}) {
-                config.colCnt = colCnt;
-                for (int rowCnt : {4'000, 20'000, 40'000, 80'000, 200'000}) {
-                    config.rowCnt = rowCnt;
-                    tableConfigs.push_back(config);
-                }
-            }
-        }
+    vector<MultiLevelTable::Config> tableConfigs = SweepTableConfigs();
+    if (mode == "runConcurrent") {
+        runConcurrent(pktTraceFilename, tableConfigs);
+    } else if (mode == "runPaced") {
+        runPaced(pktTraceFilename, tableConfigs);
+    } else if (mode == "runPorts") {
+        runPorts(pktTraceFilename, tableConfigs);
+    } else if (mode == "validateWarmup") {
+        validateWarmup(pktTraceFilename, tableConfigs);
+    } else if (mode == "whatIf") {
+        runWhatIf(pktTraceFilename, tableConfigs);
+    } else {
+        run(pktTraceFilename, tableConfigs);
     }
-    run(pktTraceFilename, tableConfigs);
 }